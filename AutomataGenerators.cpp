@@ -0,0 +1,184 @@
+//
+// AutomataGenerators.cpp
+// FiniteAutomataLabExperiments
+//
+
+#include "./AutomataGenerators.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// Every even state of a random automaton
+static vector<state> even_states(int n_states) {
+  vector<state> accepting_states;
+  for (int i = 0; i < n_states; i += 2) accepting_states.push_back(i);
+  return accepting_states;
+}
+
+// Add random edges to an NFA or ENFA.
+template <class FA>
+static void add_random_edges(FA *fa, int n_states,
+                             const vector<input_symbol> &input_symbols,
+                             double n_edges, std::mt19937 *rng) {
+  // The mean of a Poisson distribution has to be positive, with at most one
+  // edge on average there are no extra edges to draw
+  bool extra = n_edges > 1;
+  std::poisson_distribution<int> edges(extra ? n_edges - 1 : 1),
+      epsilon_edges(n_edges / 10);
+  for (int i = 0; i < n_states; ++i) {
+    for (int j = 0; j < input_symbols.size(); ++j) {
+      int n = input_symbols[j] == FA::EPSILON ? epsilon_edges(*rng) :
+                                                1 + (extra ? edges(*rng) : 0);
+      while (n--) fa->set_state(i, input_symbols[j], (*rng)() % n_states);
+    }
+  }
+}
+
+// Random DFA, every even state is accepting and every transition is present.
+DFA random_DFA(int n_states, const vector<input_symbol> &input_symbols,
+               std::mt19937 *rng) {
+  DFA dfa(n_states, input_symbols, 0, even_states(n_states));
+  for (int i = 0; i < n_states; ++i)
+    for (int j = 0; j < input_symbols.size(); ++j)
+      dfa.set_state(i, input_symbols[j], (*rng)() % n_states);
+  return dfa;
+}
+
+// DFA matching strings having the given word as a substring.
+DFA substring_DFA(const string &word,
+                  const vector<input_symbol> &input_symbols) {
+  int m = word.size();
+  DFA dfa(m + 1, input_symbols, 0, vector<state>(1, m));
+  // Longest proper prefix of word[0..q) which is also its suffix
+  state fallback = 0;
+  for (int q = 0; q <= m; ++q) {
+    for (int j = 0; j < input_symbols.size(); ++j) {
+      if (q == m)
+        dfa.set_state(q, input_symbols[j], m);
+      else if (word[q] == input_symbols[j])
+        dfa.set_state(q, input_symbols[j], q + 1);
+      else
+        dfa.set_state(q, input_symbols[j], q == 0 ? 0 :
+                      dfa.get_transition(fallback, j));
+    }
+    if (q > 0 && q < m)
+      fallback = dfa.get_transition(fallback,
+          std::find(input_symbols.begin(), input_symbols.end(), word[q]) -
+          input_symbols.begin());
+  }
+  return dfa;
+}
+
+// DFA matching a double-quoted string literal.
+DFA quoted_string_DFA() {
+  vector<input_symbol> input_symbols;
+  for (int e = 1; e < 256; ++e) input_symbols.push_back(static_cast<char>(e));
+  // 0: before the opening quote, 1: inside, 2: after the closing quote,
+  // 3: after a backslash
+  DFA dfa(4, input_symbols, 0, vector<state>(1, 2));
+  string escapes = "\"\\nt";
+  for (int e = 1; e < 256; ++e) {
+    input_symbol c = static_cast<char>(e);
+    dfa.set_state(0, c, e == '"' ? 1 : DFA::NO_STATE);
+    if (e == '"')
+      dfa.set_state(1, c, 2);
+    else if (e == '\\')
+      dfa.set_state(1, c, 3);
+    else if ((e >= ' ' && e < 127) || e >= 0xA0)
+      dfa.set_state(1, c, 1);
+    else
+      dfa.set_state(1, c, DFA::NO_STATE);
+    dfa.set_state(2, c, DFA::NO_STATE);
+    dfa.set_state(3, c, escapes.find(c) != string::npos ? 1 : DFA::NO_STATE);
+  }
+  return dfa;
+}
+
+// Random NFA, every even state is accepting.
+NFAToDFA random_NFA(int n_states, const vector<input_symbol> &input_symbols,
+                    double n_edges, std::mt19937 *rng) {
+  NFAToDFA nfa(n_states, input_symbols, vector<state>(1, 0),
+               even_states(n_states));
+  add_random_edges(&nfa, n_states, input_symbols, n_edges, rng);
+  return nfa;
+}
+
+// Random ENFA, every even state is accepting.
+ENFA random_ENFA(int n_states, const vector<input_symbol> &input_symbols,
+                 double n_edges, std::mt19937 *rng) {
+  ENFA enfa(n_states, input_symbols, 0, even_states(n_states));
+  add_random_edges(&enfa, n_states, input_symbols, n_edges, rng);
+  return enfa;
+}
+
+// NFA over {0, 1} matching strings whose n-th symbol from the end is 1.
+NFAToDFA nth_from_end_NFA(int n) {
+  vector<input_symbol> binary;
+  binary.push_back('0');
+  binary.push_back('1');
+  NFAToDFA nfa(n + 1, binary, vector<state>(1, 0), vector<state>(1, n));
+  nfa.set_state(0, '0', 0);
+  nfa.set_state(0, '1', 0);
+  nfa.set_state(0, '1', 1);
+  for (int i = 1; i < n; ++i) {
+    nfa.set_state(i, '0', i + 1);
+    nfa.set_state(i, '1', i + 1);
+  }
+  return nfa;
+}
+
+// ENFA over {0, 1} made of a chain of EPSILON transitions.
+ENFA epsilon_chain_ENFA(int n_states, bool cycle) {
+  vector<input_symbol> input_symbols;
+  input_symbols.push_back('0');
+  input_symbols.push_back('1');
+  input_symbols.push_back(ENFA::EPSILON);
+  ENFA enfa(n_states, input_symbols, 0, vector<state>(1, n_states - 1));
+  for (int i = 0; i < n_states; ++i) {
+    enfa.set_state(i, '0', i);
+    enfa.set_state(i, '1', 0);
+    if (i + 1 < n_states)
+      enfa.set_state(i, ENFA::EPSILON, i + 1);
+    else if (cycle)
+      enfa.set_state(i, ENFA::EPSILON, 0);
+  }
+  return enfa;
+}
+
+// Random string.
+string random_string(const vector<input_symbol> &input_symbols, size_t len,
+                     std::mt19937 *rng) {
+  size_t n = input_symbols.size();
+  if (n > 0 && input_symbols[n - 1] == ENFA::EPSILON) --n;
+  string str(len, '\0');
+  for (size_t i = 0; i < len; ++i) str[i] = input_symbols[(*rng)() % n];
+  return str;
+}
+
+// Random string literal accepted by quoted_string_DFA().
+string random_quoted_string(size_t len, std::mt19937 *rng) {
+  static const char escapes[] = "\"\\nt";
+  string str(1, '"');
+  while (str.size() + 1 < len) {
+    unsigned int r = (*rng)();
+    size_t left = len - 1 - str.size();
+    if (r % 8 == 0 && left >= 2) {
+      str += '\\';
+      str += escapes[(r >> 3) % 4];
+    } else if (r % 8 == 1) {
+      str += static_cast<char>(0xA0 + (r >> 3) % 96);
+    } else {
+      // Printable ASCII but the quote and the backslash
+      char c = ' ' + (r >> 3) % 95;
+      str += (c == '"' || c == '\\') ? 'x' : c;
+    }
+  }
+  str += '"';
+  return str;
+}
@@ -0,0 +1,115 @@
+//
+// AutomataGenerators.h
+// FiniteAutomataLabExperiments
+//
+// Synthetic automata and inputs for the benchmarks
+//
+
+#ifndef AUTOMATA_GENERATORS_H_
+#define AUTOMATA_GENERATORS_H_
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "./DFA.h"
+#include "./NFA_to_DFA.h"
+#include "./eClosures.h"
+
+using std::string;
+using std::vector;
+
+/**
+ Random DFA, every even state is accepting and every transition is present.
+ @param n_states Total states
+ @param input_symbols Input symbols
+ @param rng Random number generator
+ @return DFA with start state 0
+ */
+DFA random_DFA(int n_states, const vector<input_symbol> &input_symbols,
+               std::mt19937 *rng);
+
+/**
+ DFA matching strings having the given word as a substring (the KMP
+ automaton), every transition is present.
+ @param word Word to find
+ @param input_symbols Input symbols, having every symbol of the word
+ @return DFA with start state 0 and m + 1 states for a word of length m
+ */
+DFA substring_DFA(const string &word,
+                  const vector<input_symbol> &input_symbols);
+
+/**
+ DFA matching a double-quoted string literal in Latin-1: printable ASCII,
+ bytes 0xA0 to 0xFF and the escapes `\"`, `\\`, `\n` and `\t` between the
+ quotes. The input symbols are all the bytes but 0, most of them have no
+ transition outside of the quotes and control bytes have none inside.
+ @return DFA with start state 0 and 4 states
+ */
+DFA quoted_string_DFA();
+
+/**
+ Random NFA, every even state is accepting. Every state has at least one edge
+ on each symbol but EPSILON, so a run never gets stuck.
+ @param n_states Total states
+ @param input_symbols Input symbols, may have NFAToDFA::EPSILON last
+ @param n_edges Average edges per state and symbol (at least 1), EPSILON gets
+                a tenth
+ @param rng Random number generator
+ @return NFA with start state 0
+ */
+NFAToDFA random_NFA(int n_states, const vector<input_symbol> &input_symbols,
+                    double n_edges, std::mt19937 *rng);
+
+/**
+ Random ENFA, every even state is accepting. Every state has at least one
+ edge on each symbol but EPSILON, so a run never gets stuck.
+ @param n_states Total states
+ @param input_symbols Input symbols, may have ENFA::EPSILON last
+ @param n_edges Average edges per state and symbol (at least 1), EPSILON gets
+                a tenth
+ @param rng Random number generator
+ @return ENFA with start state 0, e-closures are not found yet
+ */
+ENFA random_ENFA(int n_states, const vector<input_symbol> &input_symbols,
+                 double n_edges, std::mt19937 *rng);
+
+/**
+ NFA over {0, 1} matching strings whose n-th symbol from the end is 1. It has
+ n + 1 states but its DFA has 2^n, i.e. the worst case of subset construction.
+ @param n Position from the end, at least 1
+ @return NFA with start state 0
+ */
+NFAToDFA nth_from_end_NFA(int n);
+
+/**
+ ENFA over {0, 1} made of a chain of EPSILON transitions q0 -> q1 -> ... where
+ qi also goes to itself on `0` and to q0 on `1`, and the last state accepts.
+ Closure of qi has n - i states, i.e. quadratic total closure size.
+ @param n_states Total states
+ @param cycle Whether the last state also goes back to q0 on EPSILON, which
+              puts every state in one strongly connected component
+ @return ENFA with start state 0, e-closures are not found yet
+ */
+ENFA epsilon_chain_ENFA(int n_states, bool cycle);
+
+/**
+ Random string.
+ @param input_symbols Input symbols, EPSILON is skipped if last
+ @param len Total symbols
+ @param rng Random number generator
+ @return String
+ */
+string random_string(const vector<input_symbol> &input_symbols, size_t len,
+                     std::mt19937 *rng);
+
+/**
+ Random string literal accepted by quoted_string_DFA().
+ @param len Total bytes, at least 2
+ @param rng Random number generator
+ @return String literal, quotes included
+ */
+string random_quoted_string(size_t len, std::mt19937 *rng);
+
+#endif  // AUTOMATA_GENERATORS_H_
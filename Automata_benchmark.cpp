@@ -0,0 +1,344 @@
+//
+// Automata_benchmark.cpp
+// FiniteAutomataLabExperiments
+//
+// Benchmark suite over synthetic automata: DFA::evaluate() throughput,
+// NFAToDFA::construct() time and memory, SymbolicNFA::to_CompiledDFA() time,
+// ENFA::findEClosures() and ENFA::evaluate() cost across state counts and
+// input sizes, and DFA::search() and ENFA::search() throughput.
+//
+// Output is one JSON object per line so that runs of different releases can be
+// compared by a script. The first and last lines describe the run, every other
+// line is a measurement having at least "benchmark", "family" and "seconds"
+// (best of a few repetitions). Pass `--quick` for smaller sizes. Builds having
+// FA_ENABLE_STATS defined also output the statistics (see Stats.h) right
+// before the last line.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "AutomataGenerators.h"
+#include "CompiledDFA.h"
+#include "DFA.h"
+#include "NFA_to_DFA.h"
+#include "Search.h"
+#include "Stats.h"
+#include "SymbolicNFA.h"
+#include "eClosures.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+// Version of the output format, bump on incompatible changes
+static const int OUTPUT_VERSION = 1;
+
+// Minimum time spent measuring one configuration, in seconds
+static const double MIN_SECONDS = 0.2;
+
+// Minimum repetitions of one configuration, unless they take MAX_SECONDS
+static const int MIN_REPETITIONS = 3;
+
+// Time after which a configuration is not repeated any more, in seconds
+static const double MAX_SECONDS = 2;
+
+// Seconds elapsed since the given time point
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+// One output line, fields are added in order
+class Record {
+ public:
+  Record(const char *benchmark, const string &family) {
+    out << "{\"benchmark\":\"" << benchmark << "\",\"family\":\"" << family
+        << "\"";
+  }
+
+  Record &add(const char *name, int value) {
+    out << ",\"" << name << "\":" << value;
+    return *this;
+  }
+
+  Record &add(const char *name, size_t value) {
+    out << ",\"" << name << "\":" << value;
+    return *this;
+  }
+
+  Record &add(const char *name, double value) {
+    out << ",\"" << name << "\":" << value;
+    return *this;
+  }
+
+  Record &add(const char *name, const string &value) {
+    out << ",\"" << name << "\":\"" << value << "\"";
+    return *this;
+  }
+
+  void print() { cout << out.str() << "}" << endl; }
+
+ private:
+  // Text so far
+  std::ostringstream out;
+};
+
+// Total accepted strings, so that the measured calls are not optimized away
+static size_t sink = 0;
+
+// Best time of runs taking at least MIN_SECONDS in total
+template <class F>
+static double measure(F run) {
+  double best = 0, total = 0;
+  for (int i = 0; total < MIN_SECONDS ||
+                  (i < MIN_REPETITIONS && total < MAX_SECONDS); ++i) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    run();
+    double seconds = seconds_since(start);
+    if (i == 0 || seconds < best) best = seconds;
+    total += seconds;
+  }
+  return best;
+}
+
+// DFA::evaluate() throughput over `total` bytes split into strings of `len`
+static void benchmark_dfa_evaluate(const string &family, DFA *dfa,
+                                   const vector<input_symbol> &input_symbols,
+                                   size_t len, size_t total,
+                                   std::mt19937 *rng) {
+  string str = random_string(input_symbols, len, rng);
+  size_t n = total / len > 0 ? total / len : 1;
+  double seconds = measure([&] {
+    for (size_t i = 0; i < n; ++i) sink += dfa->evaluate(str);
+  });
+  Record("dfa_evaluate", family)
+      .add("states", dfa->get_n_states())
+      .add("symbols", input_symbols.size())
+      .add("input_bytes", len)
+      .add("seconds", seconds / n)
+      .add("mb_per_s", n * len / seconds / (1 << 20))
+      .print();
+}
+
+// NFAToDFA::construct() (or construct_parallel() using n_threads threads)
+// time and memory, each run starts from a fresh copy
+static void benchmark_construct(const string &family, const NFAToDFA &nfa,
+                                int n_states, int n_threads = -1) {
+  double best = 0, total = 0;
+  int n_visited = 0;
+  size_t bytes = 0;
+  for (int i = 0; total < MIN_SECONDS ||
+                  (i < MIN_REPETITIONS && total < MAX_SECONDS); ++i) {
+    NFAToDFA copy(nfa);
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    if (n_threads < 0)
+      copy.construct(vector<state>(1, 0));
+    else
+      copy.construct_parallel(vector<state>(1, 0), n_threads);
+    double seconds = seconds_since(start);
+    if (i == 0 || seconds < best) best = seconds;
+    total += seconds;
+    n_visited = copy.get_n_visited();
+    bytes = copy.get_memory_usage();
+  }
+  Record record(n_threads < 0 ? "nfa_construct" : "nfa_construct_parallel",
+                family);
+  if (n_threads >= 0) record.add("threads", n_threads);
+  record.add("states", n_states)
+      .add("dfa_states", n_visited)
+      .add("seconds", best)
+      .add("memory_bytes", bytes)
+      .print();
+}
+
+// Random NFA over the bytes 1 to 255 whose transitions are on a few random
+// byte ranges: NFAToDFA::construct() having one input symbol per byte against
+// SymbolicNFA::to_CompiledDFA() having one edge per range
+static void benchmark_symbolic(int n_states, std::mt19937 *rng) {
+  vector<input_symbol> bytes;
+  for (int e = 1; e < 256; ++e) bytes.push_back(static_cast<char>(e));
+  vector<state> accepting_states;
+  for (int q = 0; q < n_states; q += 2) accepting_states.push_back(q);
+  NFAToDFA nfa(n_states, bytes, vector<state>(1, 0), accepting_states);
+  SymbolicNFA symbolic(n_states, vector<state>(1, 0), accepting_states);
+  for (int q = 0; q < n_states; ++q) {
+    for (int k = 0; k < 3; ++k) {
+      int first = 1 + (*rng)() % 255;
+      int last = std::min<int>(255, first + (*rng)() % 64);
+      state s = (*rng)() % n_states;
+      symbolic.set_range(q, first, last, s);
+      for (int e = first; e <= last; ++e)
+        nfa.set_state(q, static_cast<char>(e), s);
+    }
+  }
+  benchmark_construct("byte_ranges", nfa, n_states);
+  int n_dfa_states = 0, n_classes = 0;
+  double seconds = measure([&] {
+    CompiledDFA dfa = symbolic.to_CompiledDFA();
+    n_dfa_states = dfa.get_n_states() - 1;
+    n_classes = dfa.get_n_classes();
+  });
+  Record("symbolic_construct", "byte_ranges")
+      .add("states", n_states)
+      .add("dfa_states", n_dfa_states)
+      .add("minterms", n_classes)
+      .add("seconds", seconds)
+      .print();
+}
+
+// ENFA::findEClosures() time and total closure size
+static void benchmark_closures(const string &family, const ENFA &enfa) {
+  size_t closure_size = 0;
+  double seconds = measure([&] {
+    ENFA copy(enfa);
+    copy.findEClosures();
+    closure_size = 0;
+    for (int q = 0; q < copy.get_n_states(); ++q)
+      closure_size += copy.eclose(q).size();
+  });
+  Record("enfa_closures", family)
+      .add("states", enfa.get_n_states())
+      .add("closure_size", closure_size)
+      .add("seconds", seconds)
+      .print();
+}
+
+// ENFA::evaluate() throughput of one engine
+static void benchmark_enfa_evaluate(const string &family, ENFA *enfa,
+                                    ENFA::Engine engine, const char *name,
+                                    size_t len, std::mt19937 *rng) {
+  string str = random_string(enfa->get_input_symbols(), len, rng);
+  enfa->set_engine(engine);
+  double seconds = measure([&] { sink += enfa->evaluate(str); });
+  Record("enfa_evaluate", family)
+      .add("engine", name)
+      .add("states", enfa->get_n_states())
+      .add("input_bytes", len)
+      .add("seconds", seconds)
+      .add("mb_per_s", len / seconds / (1 << 20))
+      .print();
+}
+
+// Names of the search modes
+static const char *SEARCH_MODES[] = {"all", "first", "leftmost_longest"};
+
+// DFA::search() or ENFA::search() throughput of every mode
+template <class FA>
+static void benchmark_search(const char *benchmark, const string &family,
+                             FA *fa, const string &str) {
+  vector<Match> matches;
+  for (int mode = SEARCH_ALL; mode <= SEARCH_LEFTMOST_LONGEST; ++mode) {
+    double seconds = measure([&] {
+      sink += fa->search(str, static_cast<SearchMode>(mode), &matches);
+    });
+    Record(benchmark, family)
+        .add("mode", SEARCH_MODES[mode])
+        .add("states", fa->get_n_states())
+        .add("input_bytes", str.size())
+        .add("matches", matches.size())
+        .add("seconds", seconds)
+        .add("mb_per_s", str.size() / seconds / (1 << 20))
+        .print();
+  }
+}
+
+int main(int argc, char *argv[]) {
+  bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+  // Sizes are divided by `scale` in quick mode
+  int scale = quick ? 16 : 1;
+  std::mt19937 rng(2018);
+  vector<input_symbol> binary;
+  binary.push_back('0');
+  binary.push_back('1');
+  vector<input_symbol> letters;
+  for (char c = 'a'; c <= 'z'; ++c) letters.push_back(c);
+  vector<input_symbol> binary_epsilon(binary);
+  binary_epsilon.push_back(ENFA::EPSILON);
+
+  Record("run", "meta")
+      .add("version", OUTPUT_VERSION)
+      .add("quick", quick ? 1 : 0)
+      .add("compiler", __VERSION__)
+      .print();
+
+  // DFA::evaluate(): state counts (cache footprint) and string lengths (per
+  // call overhead) over the same total input
+  for (int n_states = 4; n_states <= 16384; n_states *= 16) {
+    DFA dfa = random_DFA(n_states, letters, &rng);
+    for (size_t len = 16; len <= (1 << 20); len *= 64)
+      benchmark_dfa_evaluate("random", &dfa, letters, len,
+                             (4 << 20) / scale, &rng);
+  }
+
+  // NFAToDFA::construct(): random NFAs with and without EPSILON, and the
+  // exponential n-th symbol from the end family
+  for (int n_states = 8; n_states <= 64 / (quick ? 2 : 1); n_states *= 2) {
+    benchmark_construct("random", random_NFA(n_states, binary, 1.5, &rng),
+                        n_states);
+    benchmark_construct("random_epsilon",
+                        random_NFA(n_states, binary_epsilon, 1.5, &rng),
+                        n_states);
+  }
+  for (int n = 4; n <= (quick ? 12 : 16); n += 2)
+    benchmark_construct("nth_from_end", nth_from_end_NFA(n), n + 1);
+  // NFAToDFA::construct() against SymbolicNFA::to_CompiledDFA() over a wide
+  // alphabet
+  for (int n_states = 4; n_states <= 16; n_states *= 2)
+    benchmark_symbolic(n_states, &rng);
+  // NFAToDFA::construct_parallel(): scaling with threads
+  int n_parallel = quick ? 14 : 18;
+  for (int n_threads = 1; n_threads <= 16; n_threads *= 2)
+    benchmark_construct("nth_from_end", nth_from_end_NFA(n_parallel),
+                        n_parallel + 1, n_threads);
+
+  // ENFA::findEClosures(): EPSILON chains with and without a cycle, and
+  // random ENFAs
+  for (int n_states = 256; n_states <= 4096 / scale * 4; n_states *= 4) {
+    benchmark_closures("epsilon_chain", epsilon_chain_ENFA(n_states, false));
+    benchmark_closures("epsilon_cycle", epsilon_chain_ENFA(n_states, true));
+  }
+  for (int n_states = 1024; n_states <= 65536 / scale; n_states *= 8)
+    benchmark_closures("random_epsilon",
+                       random_ENFA(n_states, binary_epsilon, 1.2, &rng));
+
+  // ENFA::evaluate(): every engine across state counts and input sizes
+  for (int n_states = 16; n_states <= 4096; n_states *= 16) {
+    ENFA enfa = random_ENFA(n_states, binary_epsilon, 1.2, &rng);
+    enfa.findEClosures();
+    for (size_t len = 1024; len <= (1 << 16) / scale; len *= 8) {
+      benchmark_enfa_evaluate("random_epsilon", &enfa, ENFA::ENGINE_SET, "set",
+                              len, &rng);
+      benchmark_enfa_evaluate("random_epsilon", &enfa, ENFA::ENGINE_LAZY_DFA,
+                              "lazy_dfa", len, &rng);
+      benchmark_enfa_evaluate("random_epsilon", &enfa,
+                              ENFA::ENGINE_BIT_PARALLEL, "bit_parallel", len,
+                              &rng);
+    }
+  }
+  // DFA::search() and ENFA::search(): a word found near the middle of the text,
+  // and a random ENFA matching almost everywhere
+  string text = random_string(letters, (1 << 20) / scale, &rng);
+  string word = random_string(letters, 8, &rng);
+  text.replace(text.size() / 2, word.size(), word);
+  DFA substring = substring_DFA(word, letters);
+  benchmark_search("dfa_search", "substring", &substring, text);
+  ENFA enfa = random_ENFA(64, binary_epsilon, 1.5, &rng);
+  enfa.findEClosures();
+  benchmark_search("enfa_search", "random_epsilon", &enfa,
+                   random_string(binary, (1 << 16) / scale, &rng));
+
+  if (Stats::is_enabled()) Stats::dump_json(&cout);
+  // Total accepted strings, also keeps the measured calls from being dropped
+  Record("run", "done").add("accepted", sink).print();
+  return 0;
+}
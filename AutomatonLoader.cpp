@@ -0,0 +1,408 @@
+//
+// AutomatonLoader.cpp
+// FiniteAutomataLabExperiments
+//
+
+#include "./AutomatonLoader.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "./MappedFile.h"
+
+using std::string;
+using std::vector;
+
+// Init MAX_CELLS
+const size_t AutomatonLoader::MAX_CELLS;
+
+// Split a line into tokens separated by spaces or tabs, returns total tokens.
+// The vectors are reused from line to line, so they rarely allocate.
+static int tokenize(const char *p, const char *end,
+                    vector<const char *> *tokens, vector<size_t> *lengths) {
+  tokens->clear();
+  lengths->clear();
+  while (p != end) {
+    while (p != end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    if (p == end) break;
+    const char *start = p;
+    while (p != end && *p != ' ' && *p != '\t' && *p != '\r') ++p;
+    tokens->push_back(start);
+    lengths->push_back(p - start);
+  }
+  return tokens->size();
+}
+
+// Remove spaces and tabs around some text
+static void trim(const char **p, const char **end) {
+  while (*p != *end && (**p == ' ' || **p == '\t' || **p == '\r')) ++*p;
+  while (*end != *p && ((*end)[-1] == ' ' || (*end)[-1] == '\t' ||
+                        (*end)[-1] == '\r'))
+    --*end;
+}
+
+// Whether a token equals a word
+static bool token_is(const char *token, size_t len, const char *word) {
+  return len == strlen(word) && memcmp(token, word, len) == 0;
+}
+
+// Constructor.
+AutomatonLoader::AutomatonLoader() : line(0), n_states(-1) {
+  for (int e = 0; e < 256; ++e) symbol_index[e] = -1;
+}
+
+// Load an automaton from a file, the file is memory-mapped.
+bool AutomatonLoader::load_file(const char *path) {
+  MappedFile file(path);
+  if (!file.is_open()) {
+    line = 0;
+    error = string("cannot open ") + path;
+    return false;
+  }
+  return load(file.data(), file.size());
+}
+
+// Load an automaton from text.
+bool AutomatonLoader::load(const char *text, size_t len) {
+  accepting_states.clear();
+  error.clear();
+  input_symbols.clear();
+  line = 0;
+  n_states = -1;
+  offsets.clear();
+  start_states.clear();
+  targets.clear();
+  for (int e = 0; e < 256; ++e) symbol_index[e] = -1;
+  // Also keeps a NULL text of an empty file away from memchr()
+  if (len == 0) return fail("no states");
+
+  const char *p = text, *end = text + len;
+  // Reserve for one edge per line up front
+  vector<state> edges;
+  edges.reserve(3 * (std::count(p, end, '\n') + 1));
+  // The first line which is neither empty nor a comment decides the layout
+  const char *first = p;
+  while (first != end) {
+    const char *eol =
+        static_cast<const char *>(memchr(first, '\n', end - first));
+    if (eol == NULL) eol = end;
+    const char *b = first, *e = eol;
+    trim(&b, &e);
+    if (b != e && *b != '#') break;
+    first = (eol == end ? end : eol + 1);
+  }
+  const char *eol = static_cast<const char *>(memchr(first, '\n', end - first));
+  string title(first, eol == NULL ? end : eol);
+  bool ok = title.find("Transition Table") != string::npos ?
+      load_table(p, end, &edges) : load_edge_list(p, end, &edges);
+  if (!ok) return false;
+  if (n_states <= 0) {
+    line = 0;
+    return fail("no states");
+  }
+
+  // Group the edges by state and symbol using a counting sort
+  size_t n_cells = static_cast<size_t>(n_states) * input_symbols.size();
+  if (n_cells > MAX_CELLS) {
+    line = 0;
+    return fail("too many states times input symbols");
+  }
+  offsets.assign(n_cells + 1, 0);
+  for (size_t i = 0; i < edges.size(); i += 3)
+    ++offsets[edges[i] * input_symbols.size() + edges[i + 1] + 1];
+  for (size_t c = 0; c < n_cells; ++c) offsets[c + 1] += offsets[c];
+  targets.resize(edges.size() / 3);
+  vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < edges.size(); i += 3)
+    targets[fill[edges[i] * input_symbols.size() + edges[i + 1]]++] =
+        edges[i + 2];
+  if (start_states.empty()) start_states.push_back(0);
+  return true;
+}
+
+// Load the edge list layout.
+bool AutomatonLoader::load_edge_list(const char *p, const char *end,
+                                     vector<state> *edges) {
+  // Tokens of the current line, e.g. all the bytes of `symbols`
+  vector<const char *> tokens;
+  vector<size_t> lengths;
+  bool has_symbols = false;
+  while (p != end) {
+    ++line;
+    const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+    if (eol == NULL) eol = end;
+    int n = tokenize(p, eol, &tokens, &lengths);
+    p = (eol == end ? end : eol + 1);
+    if (n == 0 || tokens[0][0] == '#') continue;
+    if (token_is(tokens[0], lengths[0], "states")) {
+      if (n_states >= 0) return fail("duplicate `states`");
+      if (n != 2) return fail("`states` takes one number");
+      state q;
+      if (!parse_state(tokens[1], lengths[1], &q)) return false;
+      if (q > MAX_CELLS) return fail("too many states");
+      n_states = q;
+    } else if (token_is(tokens[0], lengths[0], "symbols")) {
+      if (has_symbols) return fail("duplicate `symbols`");
+      has_symbols = true;
+      for (int i = 1; i < n; ++i) {
+        input_symbol e;
+        if (!parse_symbol(tokens[i], lengths[i], &e)) return false;
+        if (!add_input_symbol(e)) return fail("duplicate input symbol");
+      }
+    } else if (token_is(tokens[0], lengths[0], "start") ||
+               token_is(tokens[0], lengths[0], "accept")) {
+      if (n_states < 0) return fail("`states` has to come first");
+      vector<state> &states = tokens[0][0] == 's' ? start_states :
+                                                    accepting_states;
+      for (int i = 1; i < n; ++i) {
+        state q;
+        if (!parse_state(tokens[i], lengths[i], &q)) return false;
+        states.push_back(q);
+      }
+    } else {
+      if (n_states < 0 || !has_symbols)
+        return fail("`states` and `symbols` have to come before the edges");
+      if (n != 3) return fail("an edge is `state symbol state`");
+      state q, s;
+      input_symbol e;
+      if (!parse_state(tokens[0], lengths[0], &q) ||
+          !parse_symbol(tokens[1], lengths[1], &e) ||
+          !parse_state(tokens[2], lengths[2], &s))
+        return false;
+      int index = symbol_index[static_cast<unsigned char>(e)];
+      if (index < 0) return fail("not an input symbol");
+      edges->push_back(q);
+      edges->push_back(index);
+      edges->push_back(s);
+    }
+  }
+  if (!has_symbols) return fail("missing `symbols`");
+  return true;
+}
+
+// Load the transition table layout.
+bool AutomatonLoader::load_table(const char *p, const char *end,
+                                 vector<state> *edges) {
+  // Rows are counted while reading, so states are checked at the end
+  bool nfa = false;
+  int row = -1;
+  vector<state> labels;
+  while (p != end) {
+    ++line;
+    const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+    if (eol == NULL) eol = end;
+    const char *b = p, *e = eol;
+    p = (eol == end ? end : eol + 1);
+    trim(&b, &e);
+    if (row < 0) {
+      // Title, then the header having the input symbols
+      if (b == e || *b == '#') continue;
+      if (input_symbols.empty() && row == -1 && e - b >= 16 &&
+          string(b, e).find("Transition Table") != string::npos) {
+        nfa = string(b, e).find("NFA") != string::npos;
+        row = -2;
+        continue;
+      }
+      if (row == -2) {
+        // `| 0 | 1 |`, `E` stands for EPSILON in an NFA table
+        const char *cell = static_cast<const char *>(memchr(b, '|', e - b));
+        while (cell != NULL) {
+          const char *next = static_cast<const char *>(
+              memchr(cell + 1, '|', e - cell - 1));
+          if (next == NULL) break;
+          const char *cb = cell + 1, *ce = next;
+          trim(&cb, &ce);
+          if (ce - cb != 1) return fail("an input symbol is one character");
+          input_symbol sym = (nfa && *cb == 'E' ? NFAToDFA::EPSILON : *cb);
+          if (!add_input_symbol(sym)) return fail("duplicate input symbol");
+          cell = next;
+        }
+        if (input_symbols.empty()) return fail("no input symbols");
+        row = -3;
+        continue;
+      }
+      // Dashes below the header
+      row = 0;
+      continue;
+    }
+    // The table ends at the first empty line
+    if (b == e) break;
+    // `->  * q0 | q1 | q2 |` or `-> * q0 | { q0, q1 } | {  } |`
+    const char *bar = static_cast<const char *>(memchr(b, '|', e - b));
+    if (bar == NULL) return fail("missing `|`");
+    string label(b, bar);
+    bool is_start = label.find("->") != string::npos;
+    size_t star = label.find('*');
+    size_t q_pos = label.find('q', star == string::npos ? 0 : star);
+    state q;
+    if (q_pos == string::npos) return fail("missing state");
+    const char *lb = b + q_pos, *le = bar;
+    trim(&lb, &le);
+    if (!parse_state(lb, le - lb, &q)) return false;
+    if (is_start) start_states.push_back(q);
+    if (star != string::npos) accepting_states.push_back(q);
+    labels.push_back(q);
+    int index = 0;
+    for (const char *cell = bar; index < input_symbols.size(); ++index) {
+      const char *next = static_cast<const char *>(
+          memchr(cell + 1, '|', e - cell - 1));
+      if (next == NULL) return fail("missing cells");
+      const char *cb = cell + 1, *ce = next;
+      trim(&cb, &ce);
+      cell = next;
+      // `-` is DFA::NO_STATE, braces hold a set of states
+      if (ce - cb == 1 && *cb == '-') continue;
+      if (cb != ce && *cb == '{') {
+        if (ce[-1] != '}') return fail("missing `}`");
+        ++cb;
+        --ce;
+      }
+      while (cb != ce) {
+        const char *comma = static_cast<const char *>(memchr(cb, ',', ce - cb));
+        const char *sb = cb, *se = (comma == NULL ? ce : comma);
+        cb = (comma == NULL ? ce : comma + 1);
+        trim(&sb, &se);
+        if (sb == se) {
+          if (comma == NULL) break;
+          return fail("missing state");
+        }
+        state s;
+        if (!parse_state(sb, se - sb, &s)) return false;
+        edges->push_back(q);
+        edges->push_back(index);
+        edges->push_back(s);
+      }
+    }
+    ++row;
+  }
+  // Now that the total states are known, check the states
+  n_states = std::max(row, 0);
+  // Every state labels exactly one row
+  vector<bool> seen(n_states, false);
+  for (size_t i = 0; i < labels.size(); ++i) {
+    if (labels[i] >= n_states) return fail("row label out of range");
+    if (seen[labels[i]]) return fail("duplicate row label");
+    seen[labels[i]] = true;
+  }
+  for (size_t i = 2; i < edges->size(); i += 3)
+    if ((*edges)[i] >= n_states) return fail("state out of range");
+  return true;
+}
+
+// Add an input symbol.
+bool AutomatonLoader::add_input_symbol(input_symbol e) {
+  int &index = symbol_index[static_cast<unsigned char>(e)];
+  if (index >= 0) return false;
+  index = input_symbols.size();
+  input_symbols.push_back(e);
+  return true;
+}
+
+// Parse a state, checking it against the total states if known.
+bool AutomatonLoader::parse_state(const char *token, size_t len, state *q) {
+  if (len > 0 && *token == 'q') {
+    ++token;
+    --len;
+  }
+  if (len == 0 || len > 9) return fail("invalid state");
+  state value = 0;
+  for (size_t i = 0; i < len; ++i) {
+    if (token[i] < '0' || token[i] > '9') return fail("invalid state");
+    value = value * 10 + (token[i] - '0');
+  }
+  if (n_states >= 0 && value >= n_states) return fail("state out of range");
+  *q = value;
+  return true;
+}
+
+// Parse a symbol of the edge list layout.
+bool AutomatonLoader::parse_symbol(const char *token, size_t len,
+                                   input_symbol *e) {
+  if (len == 1 && *token != '\\') {
+    *e = *token;
+    return true;
+  }
+  if (len == 2 && *token == '\\') {
+    switch (token[1]) {
+      case 'e': *e = NFAToDFA::EPSILON; return true;
+      case 's': *e = ' '; return true;
+      case 't': *e = '\t'; return true;
+      case '\\': *e = '\\'; return true;
+    }
+  }
+  return fail("invalid symbol");
+}
+
+// Record an error on the current line.
+bool AutomatonLoader::fail(const string &message) {
+  std::ostringstream out;
+  if (line > 0) out << "line " << line << ": ";
+  out << message;
+  error = out.str();
+  return false;
+}
+
+// Whether the automaton is deterministic.
+bool AutomatonLoader::is_deterministic() const {
+  if (!is_valid()) return false;
+  if (start_states.size() != 1) return false;
+  int k = input_symbols.size();
+  for (int q = 0; q < n_states; ++q) {
+    for (int e = 0; e < k; ++e) {
+      size_t n = offsets[q * k + e + 1] - offsets[q * k + e];
+      if (n > 1 || (n == 1 && input_symbols[e] == NFAToDFA::EPSILON))
+        return false;
+    }
+  }
+  return true;
+}
+
+// Get the automaton as a DFA.
+DFA AutomatonLoader::to_DFA() const {
+  // A single state rejecting everything
+  if (!is_valid()) return DFA(1, input_symbols, 0, vector<state>());
+  DFA dfa(n_states, input_symbols, start_states[0], accepting_states);
+  int k = input_symbols.size();
+  for (int q = 0; q < n_states; ++q)
+    for (int e = 0; e < k; ++e)
+      dfa.set_state(q, input_symbols[e], offsets[q * k + e] ==
+                    offsets[q * k + e + 1] ? DFA::NO_STATE :
+                    targets[offsets[q * k + e]]);
+  return dfa;
+}
+
+// Get the automaton as an ENFA.
+ENFA AutomatonLoader::to_ENFA() const {
+  if (!is_valid()) {
+    ENFA enfa(1, input_symbols, 0, vector<state>());
+    enfa.findEClosures();
+    return enfa;
+  }
+  ENFA enfa(n_states, input_symbols, start_states[0], accepting_states);
+  int k = input_symbols.size();
+  for (int q = 0; q < n_states; ++q)
+    for (int e = 0; e < k; ++e)
+      if (offsets[q * k + e] != offsets[q * k + e + 1])
+        enfa.set_states(q, input_symbols[e], &targets[offsets[q * k + e]],
+                        &targets[0] + offsets[q * k + e + 1]);
+  enfa.findEClosures();
+  return enfa;
+}
+
+// Get the automaton for subset construction.
+NFAToDFA AutomatonLoader::to_NFAToDFA() const {
+  if (!is_valid())
+    return NFAToDFA(1, input_symbols, vector<state>(1, 0), vector<state>());
+  NFAToDFA ntd(n_states, input_symbols, start_states, accepting_states);
+  int k = input_symbols.size();
+  for (int q = 0; q < n_states; ++q)
+    for (int e = 0; e < k; ++e)
+      if (offsets[q * k + e] != offsets[q * k + e + 1])
+        ntd.set_states(q, input_symbols[e], &targets[offsets[q * k + e]],
+                       &targets[0] + offsets[q * k + e + 1]);
+  return ntd;
+}
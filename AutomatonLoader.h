@@ -0,0 +1,201 @@
+//
+// AutomatonLoader.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef AUTOMATON_LOADER_H_
+#define AUTOMATON_LOADER_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "./DFA.h"
+#include "./NFA_to_DFA.h"
+#include "./eClosures.h"
+
+using std::string;
+using std::vector;
+
+/**
+ Bulk loader for automata written as text.
+
+ Two layouts are understood. The edge list, one directive or edge per line
+ (`#` starts a comment line, the directives have to come before the edges):
+
+     states 4
+     symbols 0 1 \e
+     start 0
+     accept 3
+     0 0 1
+     q1 \e q2
+
+ A state is written as `N` or `qN`. A symbol is a single character, or one of
+ the escapes `\e` (EPSILON), `\s` (space), `\t` (tab) and `\\`.
+
+ The transition table layout written by DFA::print_transition_table() and
+ NFAToDFA::print_NFA_transition_table(), where `E` is EPSILON in an NFA table.
+
+ The input is read in one pass, every state and symbol is validated as it is
+ read, and the edges are then grouped by state and symbol with a counting
+ sort so that each transition table cell is allocated only once. Automata
+ having more than MAX_CELLS states times input symbols are rejected.
+ */
+class AutomatonLoader {
+ public:
+  // Most transition table cells, i.e. states times input symbols
+  static const size_t MAX_CELLS = static_cast<size_t>(1) << 24;
+
+  /**
+   Constructor.
+   */
+  AutomatonLoader();
+
+  /**
+   Load an automaton from a file, the file is memory-mapped.
+   @param path Path to the file
+   @return True on success, false otherwise (see get_error())
+   */
+  bool load_file(const char *path);
+
+  /**
+   Load an automaton from text.
+   @param text Text to read
+   @param len Length of the text
+   @return True on success, false otherwise (see get_error())
+   */
+  bool load(const char *text, size_t len);
+
+  /**
+   Get the error of the last load.
+   @return Error message with its line number, empty if there was none
+   */
+  const string &get_error() const { return error; }
+
+  /**
+   Whether the last load succeeded. Otherwise the conversions below return a
+   single state automaton rejecting everything.
+   @return True if an automaton is loaded, false otherwise
+   */
+  bool is_valid() const { return error.empty() && n_states > 0; }
+
+  /**
+   Whether the automaton is deterministic: a single start state, no EPSILON
+   edges and at most one edge per state and symbol.
+   @return True if deterministic, false otherwise
+   */
+  bool is_deterministic() const;
+
+  /**
+   Get the automaton as a DFA, missing edges become DFA::NO_STATE. Only the
+   first start state and the first edge of each state and symbol are used, so
+   the automaton should be deterministic.
+   @return DFA
+   */
+  DFA to_DFA() const;
+
+  /**
+   Get the automaton as an ENFA, e-closures are found already. Only the first
+   start state is used.
+   @return ENFA
+   */
+  ENFA to_ENFA() const;
+
+  /**
+   Get the automaton for subset construction.
+   @return NFA
+   */
+  NFAToDFA to_NFAToDFA() const;
+
+  /**
+   Get total states.
+   @return Total states
+   */
+  int get_n_states() const { return n_states; }
+
+  /**
+   Get total edges.
+   @return Total edges
+   */
+  size_t get_n_edges() const { return targets.size(); }
+
+ private:
+  // Accepting states
+  vector<state> accepting_states;
+
+  // Error of the last load
+  string error;
+
+  // Input symbols
+  vector<input_symbol> input_symbols;
+
+  // Current line number while loading
+  size_t line;
+
+  // Total states, -1 if not known yet
+  int n_states;
+
+  // Edges per state and symbol: targets[offsets[q * k + e]..] for k symbols
+  vector<size_t> offsets;
+
+  // Start states
+  vector<state> start_states;
+
+  // Index of each input symbol (as unsigned char), -1 if not an input symbol
+  int symbol_index[256];
+
+  // Destination states of the edges, grouped by state and symbol
+  vector<state> targets;
+
+  /**
+   Load the edge list layout.
+   @param p Start of the text
+   @param end End of the text
+   @param edges Output: source, symbol index and destination of each edge
+   @return True on success, false otherwise
+   */
+  bool load_edge_list(const char *p, const char *end, vector<state> *edges);
+
+  /**
+   Load the transition table layout.
+   @param p Start of the text, i.e. the title line
+   @param end End of the text
+   @param edges Output: source, symbol index and destination of each edge
+   @return True on success, false otherwise
+   */
+  bool load_table(const char *p, const char *end, vector<state> *edges);
+
+  /**
+   Add an input symbol.
+   @param e Input symbol
+   @return True on success, false if it is a duplicate
+   */
+  bool add_input_symbol(input_symbol e);
+
+  /**
+   Parse a state, checking it against the total states if known.
+   @param token State as text
+   @param len Length of the text
+   @param q Output: state
+   @return True on success, false otherwise
+   */
+  bool parse_state(const char *token, size_t len, state *q);
+
+  /**
+   Parse a symbol of the edge list layout.
+   @param token Symbol as text
+   @param len Length of the text
+   @param e Output: symbol
+   @return True on success, false otherwise
+   */
+  bool parse_symbol(const char *token, size_t len, input_symbol *e);
+
+  /**
+   Record an error on the current line.
+   @param message Error message
+   @return Always false
+   */
+  bool fail(const string &message);
+};
+
+#endif  // AUTOMATON_LOADER_H_
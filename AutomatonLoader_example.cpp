@@ -0,0 +1,61 @@
+//
+// AutomatonLoader_example.cpp
+// FiniteAutomataLabExperiments
+//
+// Load an automaton from the file given as the first argument (or the NFA
+// below, matching strings having `0` as the third last symbol) and match
+// strings with it, `-1` to exit
+//
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "AutomatonLoader.h"
+#include "DFA.h"
+#include "NFA_to_DFA.h"
+
+using std::cin;
+using std::cout;
+using std::endl;
+using std::string;
+
+static const char *third_last_0 =
+    "# Third last symbol is 0\n"
+    "states 4\n"
+    "symbols 0 1\n"
+    "start 0\n"
+    "accept 3\n"
+    "0 0 0\n"
+    "0 1 0\n"
+    "0 0 1\n"
+    "1 0 2\n"
+    "1 1 2\n"
+    "2 0 3\n"
+    "2 1 3\n";
+
+int main(int argc, char *argv[]) {
+  AutomatonLoader loader;
+  bool loaded = argc > 1 ? loader.load_file(argv[1]) :
+      loader.load(third_last_0, strlen(third_last_0));
+  if (!loaded) {
+    cout << "Cannot load: " << loader.get_error() << endl;
+    return 1;
+  }
+  cout << "Loaded " << loader.get_n_states() << " states, "
+       << loader.get_n_edges() << " edges\n" << endl;
+
+  // Nondeterministic automata go through subset construction first
+  NFAToDFA ntd = loader.to_NFAToDFA();
+  DFA dfa = loader.is_deterministic() ? loader.to_DFA() : ntd.to_DFA();
+  dfa.print_transition_table();
+
+  string str;
+  while (true) {
+    cout << "Enter a string: "; cin >> str;
+    if (str == "-1") break;
+    bool status = dfa.evaluate(str);
+    cout << "Status: " << (status ? "Accepted" : "Rejected") << "\n" << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,593 @@
+//
+// CompiledDFA.cpp
+// FiniteAutomataLabExperiments
+//
+
+#include "./CompiledDFA.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "./ThreadPool.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+// Binary file format version, 2 has the header in the checksum
+static const uint32_t FILE_VERSION = 2;
+
+// Byte order mark, read back differently on the other byte order
+static const uint32_t FILE_BYTE_ORDER = 0x01020304;
+
+// Magic bytes at the start of a file
+static const char FILE_MAGIC[8] = { 'F', 'A', 'D', 'F', 'A', '\0', '\r', '\n' };
+
+// Strings per chunk of a pool, a multiple of 64 so that no two chunks write
+// the same word of the bitmap
+static const size_t BATCH_GRAIN = 1024;
+
+// Alignment of the tables in a file
+static const size_t FILE_ALIGNMENT = 64;
+
+/**
+ Header of the binary file format.
+ */
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t n_states;
+  uint32_t n_classes;
+  uint32_t start_state;
+  uint32_t dead_state;
+  uint64_t classes_offset;
+  uint64_t transitions_offset;
+  uint64_t accepting_offset;
+  uint64_t size;
+  // FNV-1a checksum of the whole file, this field being zero
+  uint64_t checksum;
+  uint64_t reserved[6];
+};
+
+// Round up to the alignment of the tables
+static uint64_t align(uint64_t offset) {
+  return (offset + FILE_ALIGNMENT - 1) / FILE_ALIGNMENT * FILE_ALIGNMENT;
+}
+
+// FNV-1a checksum of some bytes, continuing from a previous checksum
+static uint64_t checksum(const char *bytes, size_t len,
+                         uint64_t h = 14695981039346656037ULL) {
+  for (size_t i = 0; i < len; ++i) {
+    h ^= static_cast<unsigned char>(bytes[i]);
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+// Checksum of a file image, the header included with its checksum zeroed
+static uint64_t file_checksum(const FileHeader &header, const char *base) {
+  FileHeader zeroed = header;
+  zeroed.checksum = 0;
+  uint64_t h = checksum(reinterpret_cast<const char *>(&zeroed),
+                        sizeof(zeroed));
+  return checksum(base + sizeof(header), header.size - sizeof(header), h);
+}
+
+// Whether a table of n_bytes at the given offset ends within size bytes,
+// without overflowing
+static bool fits(uint64_t offset, uint64_t n_bytes, uint64_t size) {
+  return offset <= size && n_bytes <= size - offset;
+}
+
+// Constructor.
+CompiledDFA::CompiledDFA(const DFA &dfa) {
+  const vector<input_symbol> &input_symbols = dfa.get_input_symbols();
+  int n_dfa_states = dfa.get_n_states();
+  // Group input symbols having identical columns into one symbol class, class
+  // zero is reserved for the bytes outside of the alphabet
+  map< vector<state>, int > column_to_class;
+  vector< vector<state> > columns(1,
+                                  vector<state>(n_dfa_states, DFA::NO_STATE));
+  vector<int> symbol_to_class(input_symbols.size());
+  for (int j = 0; j < input_symbols.size(); ++j) {
+    vector<state> column(n_dfa_states);
+    for (int i = 0; i < n_dfa_states; ++i) column[i] = dfa.get_transition(i, j);
+    map< vector<state>, int >::iterator it = column_to_class.find(column);
+    if (it == column_to_class.end()) {
+      it = column_to_class.insert(std::make_pair(column, columns.size())).first;
+      columns.push_back(column);
+    }
+    symbol_to_class[j] = it->second;
+  }
+  state classes[256] = { 0 };
+  // DFA::get_index_by_input_symbol() prefers the last duplicate symbol
+  for (int j = 0; j < input_symbols.size(); ++j)
+    classes[static_cast<unsigned char>(input_symbols[j])] = symbol_to_class[j];
+  int width = columns.size();
+  vector<state> table(static_cast<size_t>(n_dfa_states) * width);
+  for (int c = 0; c < width; ++c)
+    for (int i = 0; i < n_dfa_states; ++i)
+      table[static_cast<size_t>(i) * width + c] = columns[c][i];
+  vector<bool> accepting(n_dfa_states);
+  for (int i = 0; i < n_dfa_states; ++i)
+    accepting[i] = dfa.is_accepting_state(i);
+  compile(classes, width, n_dfa_states, table, dfa.get_start_state(),
+          accepting);
+}
+
+// Constructor from raw tables.
+CompiledDFA::CompiledDFA(const state *symbol_classes, int n_classes,
+                         int n_states, const vector<state> &transitions,
+                         state start_state,
+                         const vector<bool> &accepting_states) {
+  compile(symbol_classes, n_classes, n_states, transitions, start_state,
+          accepting_states);
+}
+
+// Lay out the file image of a DFA and point the tables to it.
+void CompiledDFA::compile(const state *classes, int width, int n_dfa_states,
+                          const vector<state> &rows, state start,
+                          const vector<bool> &accepting) {
+  FileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+  header.version = FILE_VERSION;
+  header.byte_order = FILE_BYTE_ORDER;
+  header.n_states = n_dfa_states + 1;
+  header.n_classes = width;
+  header.start_state = start * width;
+  header.dead_state = n_dfa_states * width;
+  header.classes_offset = align(sizeof(header));
+  header.transitions_offset =
+      align(header.classes_offset + 256 * sizeof(state));
+  header.accepting_offset = align(header.transitions_offset +
+      static_cast<uint64_t>(header.n_states) * width * sizeof(state));
+  header.size = align(header.accepting_offset +
+                      (header.n_states + 63) / 64 * sizeof(uint64_t));
+  image.assign(header.size / sizeof(uint64_t), 0);
+  char *base = reinterpret_cast<char *>(&image[0]);
+
+  memcpy(base + header.classes_offset, classes, 256 * sizeof(state));
+  // Row offsets instead of state numbers, the dead state is the last row
+  state *table = reinterpret_cast<state *>(base + header.transitions_offset);
+  size_t n_cells = static_cast<size_t>(n_dfa_states) * width;
+  for (size_t i = 0; i < n_cells; ++i)
+    table[i] = (rows[i] == DFA::NO_STATE ? n_dfa_states : rows[i]) * width;
+  for (int c = 0; c < width; ++c) table[n_cells + c] = n_dfa_states * width;
+  // Accept bitmap
+  uint64_t *accept =
+      reinterpret_cast<uint64_t *>(base + header.accepting_offset);
+  for (int i = 0; i < n_dfa_states; ++i)
+    if (accepting[i]) accept[i >> 6] |= static_cast<uint64_t>(1) << (i & 63);
+  header.checksum = file_checksum(header, base);
+  memcpy(base, &header, sizeof(header));
+  attach(base);
+}
+
+// Constructor, loads a DFA written by save().
+CompiledDFA::CompiledDFA(const char *path, bool verify)
+    : accepting_states(NULL), dead_state(0), n_classes(0), n_states(0),
+      start_state(0), symbol_classes(NULL), transitions(NULL),
+      mapping(new MappedFile(path, MappedFile::RANDOM)) {
+  if (!mapping->is_open() || mapping->size() < sizeof(FileHeader)) return;
+  const char *base = mapping->data();
+  FileHeader header;
+  memcpy(&header, base, sizeof(header));
+  uint64_t n_cells = static_cast<uint64_t>(header.n_states) * header.n_classes;
+  if (memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != FILE_VERSION || header.byte_order != FILE_BYTE_ORDER ||
+      header.size != mapping->size() || header.n_states == 0 ||
+      header.n_classes == 0 || n_cells > static_cast<state>(-1) ||
+      header.start_state >= n_cells || header.dead_state >= n_cells ||
+      header.start_state % header.n_classes != 0 ||
+      header.dead_state % header.n_classes != 0 ||
+      header.classes_offset % FILE_ALIGNMENT != 0 ||
+      header.transitions_offset % FILE_ALIGNMENT != 0 ||
+      header.accepting_offset % FILE_ALIGNMENT != 0 ||
+      header.classes_offset < sizeof(header) ||
+      header.transitions_offset < sizeof(header) ||
+      header.accepting_offset < sizeof(header) ||
+      !fits(header.classes_offset, 256 * sizeof(state), header.size) ||
+      !fits(header.transitions_offset, n_cells * sizeof(state),
+            header.size) ||
+      !fits(header.accepting_offset,
+            (header.n_states + 63) / 64 * sizeof(uint64_t), header.size))
+    return;
+  const state *classes =
+      reinterpret_cast<const state *>(base + header.classes_offset);
+  for (int e = 0; e < 256; ++e)
+    if (classes[e] >= header.n_classes) return;
+  if (verify) {
+    if (file_checksum(header, base) != header.checksum) return;
+    const state *table =
+        reinterpret_cast<const state *>(base + header.transitions_offset);
+    for (uint64_t i = 0; i < n_cells; ++i)
+      if (table[i] >= n_cells || table[i] % header.n_classes != 0) return;
+  }
+  attach(base);
+}
+
+// Copy constructor.
+CompiledDFA::CompiledDFA(const CompiledDFA &other)
+    : accepting_states(NULL), dead_state(0), n_classes(0), n_states(0),
+      start_state(0), symbol_classes(NULL), transitions(NULL),
+      image(other.image), mapping(other.mapping) {
+  if (other.is_valid())
+    attach(image.empty() ? mapping->data()
+                         : reinterpret_cast<const char *>(&image[0]));
+}
+
+// Assignment operator.
+CompiledDFA &CompiledDFA::operator=(const CompiledDFA &other) {
+  if (this == &other) return *this;
+  image = other.image;
+  mapping = other.mapping;
+  accepting_states = NULL;
+  dead_state = 0;
+  n_classes = 0;
+  n_states = 0;
+  start_state = 0;
+  symbol_classes = NULL;
+  transitions = NULL;
+  if (other.is_valid())
+    attach(image.empty() ? mapping->data()
+                         : reinterpret_cast<const char *>(&image[0]));
+  return *this;
+}
+
+// Point the tables to a file image and read the header.
+void CompiledDFA::attach(const char *base) {
+  FileHeader header;
+  memcpy(&header, base, sizeof(header));
+  n_states = header.n_states;
+  n_classes = header.n_classes;
+  start_state = header.start_state;
+  dead_state = header.dead_state;
+  symbol_classes =
+      reinterpret_cast<const state *>(base + header.classes_offset);
+  transitions =
+      reinterpret_cast<const state *>(base + header.transitions_offset);
+  accepting_states =
+      reinterpret_cast<const uint64_t *>(base + header.accepting_offset);
+}
+
+// Write the DFA in the binary format.
+bool CompiledDFA::save(const char *path) const {
+  if (!is_valid()) return false;
+  const char *base = image.empty() ? mapping->data()
+                                   : reinterpret_cast<const char *>(&image[0]);
+  FileHeader header;
+  memcpy(&header, base, sizeof(header));
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) return false;
+  bool written = fwrite(base, 1, header.size, file) == header.size;
+  return fclose(file) == 0 && written;
+}
+
+// Run the given bytes from some state.
+state CompiledDFA::run(state q, const char *str, size_t len) const {
+  const state *table = transitions;
+  const state *symbol_classes = this->symbol_classes;
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(str);
+  const unsigned char *end = p + len;
+  // Unrolled by four, each step is two dependent loads without any branch
+  for ( ; end - p >= 4; p += 4) {
+    q = table[q + symbol_classes[p[0]]];
+    q = table[q + symbol_classes[p[1]]];
+    q = table[q + symbol_classes[p[2]]];
+    q = table[q + symbol_classes[p[3]]];
+  }
+  for ( ; p != end; ++p) q = table[q + symbol_classes[*p]];
+  return q;
+}
+
+// Find the states which can reach an accepting state.
+void CompiledDFA::find_live_states(vector<bool> *live) const {
+  vector< vector<state> > reverse(n_states);
+  vector<state> stack;
+  live->assign(n_states, false);
+  for (int q = 0; q < n_states; ++q) {
+    for (int c = 0; c < n_classes; ++c)
+      reverse[transitions[q * n_classes + c] / n_classes].push_back(q);
+    if (is_accepting_state(q * n_classes)) {
+      (*live)[q] = true;
+      stack.push_back(q);
+    }
+  }
+  while (!stack.empty()) {
+    state q = stack.back();
+    stack.pop_back();
+    for (int i = 0; i < reverse[q].size(); ++i) {
+      if (!(*live)[reverse[q][i]]) {
+        (*live)[reverse[q][i]] = true;
+        stack.push_back(reverse[q][i]);
+      }
+    }
+  }
+}
+
+// Evaluate many independent strings at once.
+void CompiledDFA::evaluate_batch(const vector<string> &strs,
+                                 vector<uint64_t> *accepted, int width,
+                                 bool simd) const {
+  accepted->assign((strs.size() + 63) / 64, 0);
+#ifdef __AVX2__
+  if (simd && width == 8) {
+    evaluate_gather(strs, accepted);
+    return;
+  }
+#else
+  (void)simd;
+#endif
+  switch (width) {
+    case 1: evaluate_lanes<1>(strs, 0, strs.size(), accepted); break;
+    case 2: evaluate_lanes<2>(strs, 0, strs.size(), accepted); break;
+    case 4: evaluate_lanes<4>(strs, 0, strs.size(), accepted); break;
+    case 16: evaluate_lanes<16>(strs, 0, strs.size(), accepted); break;
+    default: evaluate_lanes<8>(strs, 0, strs.size(), accepted); break;
+  }
+}
+
+// Evaluate many independent strings spread over the threads of a pool.
+void CompiledDFA::evaluate_batch(const vector<string> &strs,
+                                 vector<uint64_t> *accepted,
+                                 ThreadPool *pool) const {
+  accepted->assign((strs.size() + 63) / 64, 0);
+  pool->parallel_for(strs.size(), BATCH_GRAIN, [&](size_t first,
+                                                   size_t last) {
+    evaluate_lanes<8>(strs, first, last, accepted);
+  });
+}
+
+// Evaluate every line of a file as an independent string.
+bool CompiledDFA::evaluate_lines(const char *path, ThreadPool *pool,
+                                 vector<uint64_t> *accepted,
+                                 size_t *n_lines) const {
+  MappedFile file(path);
+  if (!file.is_open()) return false;
+  // Offset of every line, then one past the `\n` ending the last one
+  vector<size_t> starts;
+  const char *bytes = file.data();
+  size_t size = file.size();
+  for (size_t i = 0; i < size; ) {
+    starts.push_back(i);
+    const void *eol = memchr(bytes + i, '\n', size - i);
+    i = eol == NULL ? size : static_cast<const char *>(eol) - bytes + 1;
+  }
+  starts.push_back(size > 0 && bytes[size - 1] == '\n' ? size : size + 1);
+  *n_lines = starts.size() - 1;
+  accepted->assign((*n_lines + 63) / 64, 0);
+  pool->parallel_for(*n_lines, BATCH_GRAIN, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      if (evaluate(bytes + starts[i], starts[i + 1] - 1 - starts[i]))
+        (*accepted)[i >> 6] |= static_cast<uint64_t>(1) << (i & 63);
+    }
+  });
+  return true;
+}
+
+// Evaluate many independent strings using a fixed number of lanes.
+template <int WIDTH>
+void CompiledDFA::evaluate_lanes(const vector<string> &strs, size_t first,
+                                 size_t last,
+                                 vector<uint64_t> *accepted) const {
+  const state *table = transitions;
+  const unsigned char *ptr[WIDTH];
+  size_t remaining[WIDTH];
+  size_t index[WIDTH];
+  state q[WIDTH];
+  size_t next = first;
+  int active = 0;
+  // Fill the lanes, empty strings are settled right away
+  for ( ; active < WIDTH; ++active) {
+    while (next < last && strs[next].empty()) {
+      if (is_accepting_state(start_state))
+        (*accepted)[next >> 6] |= static_cast<uint64_t>(1) << (next & 63);
+      ++next;
+    }
+    if (next == last) break;
+    ptr[active] = reinterpret_cast<const unsigned char *>(strs[next].data());
+    remaining[active] = strs[next].size();
+    index[active] = next++;
+    q[active] = start_state;
+  }
+  // Lockstep phase: every lane is busy
+  while (active == WIDTH) {
+    size_t steps = remaining[0];
+    for (int l = 1; l < WIDTH; ++l)
+      if (remaining[l] < steps) steps = remaining[l];
+    for (size_t k = 0; k < steps; ++k)
+      for (int l = 0; l < WIDTH; ++l)
+        q[l] = table[q[l] + symbol_classes[ptr[l][k]]];
+    for (int l = 0; l < WIDTH; ++l) {
+      ptr[l] += steps;
+      remaining[l] -= steps;
+    }
+    for (int l = 0; l < active; ++l) {
+      while (remaining[l] == 0) {
+        if (is_accepting_state(q[l]))
+          (*accepted)[index[l] >> 6] |=
+              static_cast<uint64_t>(1) << (index[l] & 63);
+        if (next == last) {
+          // Out of strings: move the last lane here and shrink
+          --active;
+          ptr[l] = ptr[active];
+          remaining[l] = remaining[active];
+          index[l] = index[active];
+          q[l] = q[active];
+          if (l == active) break;
+          continue;
+        }
+        ptr[l] = reinterpret_cast<const unsigned char *>(strs[next].data());
+        remaining[l] = strs[next].size();
+        index[l] = next++;
+        q[l] = start_state;
+      }
+    }
+  }
+  // Drain the rest one by one
+  for (int l = 0; l < active; ++l) {
+    q[l] = run(q[l], reinterpret_cast<const char *>(ptr[l]), remaining[l]);
+    if (is_accepting_state(q[l]))
+      (*accepted)[index[l] >> 6] |= static_cast<uint64_t>(1) << (index[l] & 63);
+  }
+}
+
+#ifdef __AVX2__
+// Evaluate many independent strings using AVX2 gathers.
+void CompiledDFA::evaluate_gather(const vector<string> &strs,
+                                  vector<uint64_t> *accepted) const {
+  const int *table = reinterpret_cast<const int *>(transitions);
+  const int *classes = reinterpret_cast<const int *>(symbol_classes);
+  size_t i = 0;
+  // Groups of eight strings, advanced together up to the shortest one
+  for ( ; i + 8 <= strs.size(); i += 8) {
+    const unsigned char *ptr[8];
+    size_t steps = strs[i].size();
+    for (int l = 0; l < 8; ++l) {
+      ptr[l] = reinterpret_cast<const unsigned char *>(strs[i + l].data());
+      if (strs[i + l].size() < steps) steps = strs[i + l].size();
+    }
+    __m256i q = _mm256_set1_epi32(start_state);
+    for (size_t k = 0; k < steps; ++k) {
+      __m256i bytes = _mm256_setr_epi32(ptr[0][k], ptr[1][k], ptr[2][k],
+                                        ptr[3][k], ptr[4][k], ptr[5][k],
+                                        ptr[6][k], ptr[7][k]);
+      __m256i c = _mm256_i32gather_epi32(classes, bytes, 4);
+      q = _mm256_i32gather_epi32(table, _mm256_add_epi32(q, c), 4);
+    }
+    state lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), q);
+    for (int l = 0; l < 8; ++l) {
+      lanes[l] = run(lanes[l], reinterpret_cast<const char *>(ptr[l] + steps),
+                     strs[i + l].size() - steps);
+      if (is_accepting_state(lanes[l]))
+        (*accepted)[(i + l) >> 6] |=
+            static_cast<uint64_t>(1) << ((i + l) & 63);
+    }
+  }
+  for ( ; i < strs.size(); ++i)
+    if (evaluate(strs[i]))
+      (*accepted)[i >> 6] |= static_cast<uint64_t>(1) << (i & 63);
+}
+#endif
+
+// Smallest chunk worth its own thread in CompiledDFA::evaluate_parallel()
+static const size_t MIN_PARALLEL_CHUNK = 1 << 16;
+
+// Bytes run before a chunk to speculate its start state
+static const size_t SPECULATION_WINDOW = 1 << 10;
+
+// Bytes run between two merges of converged lanes in CompiledDFA::run_all()
+static const size_t MERGE_INTERVAL = 256;
+
+// Evaluate a single large input using multiple threads.
+bool CompiledDFA::evaluate_parallel(const char *str, size_t len,
+                                    int n_threads) const {
+  if (n_threads <= 0) n_threads = std::thread::hardware_concurrency();
+  if (n_threads <= 0) n_threads = 1;
+  // Not worth starting any thread
+  if (std::min<size_t>(n_threads, len / MIN_PARALLEL_CHUNK) <= 1)
+    return evaluate(str, len);
+  ThreadPool pool(n_threads);
+  return evaluate_parallel(str, len, &pool);
+}
+
+// Evaluate a single large input using the threads of a pool.
+bool CompiledDFA::evaluate_parallel(const char *str, size_t len,
+                                    ThreadPool *pool) const {
+  size_t n_chunks = std::min<size_t>(pool->get_n_threads(),
+                                     len / MIN_PARALLEL_CHUNK);
+  if (n_chunks <= 1) return evaluate(str, len);
+
+  size_t chunk_size = len / n_chunks;
+  bool enumerate = n_states <= MAX_ENUMERATED_STATES;
+  // Per chunk: mapping from every state, or the speculated start and end
+  vector< vector<state> > mappings(n_chunks);
+  vector<state> guesses(n_chunks), ends(n_chunks);
+  state q = start_state;
+  pool->parallel_for(n_chunks, 1, [&](size_t first, size_t last) {
+    for (size_t c = first; c < last; ++c) {
+      const char *begin = str + c * chunk_size;
+      size_t size = (c == n_chunks - 1 ? len - c * chunk_size : chunk_size);
+      if (c == 0) {
+        // The first chunk is run from the start state
+        q = run(start_state, begin, size);
+      } else if (enumerate) {
+        run_all(begin, size, &mappings[c]);
+      } else {
+        size_t window = std::min(SPECULATION_WINDOW, c * chunk_size);
+        guesses[c] = run(start_state, begin - window, window);
+        ends[c] = run(guesses[c], begin, size);
+      }
+    }
+  });
+  for (size_t c = 1; c < n_chunks; ++c) {
+    if (enumerate) {
+      q = mappings[c][q / n_classes];
+    } else if (q == guesses[c]) {
+      q = ends[c];
+    } else {
+      // Misspeculation: redo the chunk from the actual state
+      size_t size = (c == n_chunks - 1 ? len - c * chunk_size : chunk_size);
+      q = run(q, str + c * chunk_size, size);
+    }
+  }
+  return is_accepting_state(q);
+}
+
+// Run the given bytes from every state.
+void CompiledDFA::run_all(const char *str, size_t len,
+                          vector<state> *mapping) const {
+  const state *table = transitions;
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(str);
+  // One lane per distinct current state, lane_of maps a start state to its
+  // lane
+  vector<state> lanes(n_states);
+  vector<int> lane_of(n_states);
+  for (int i = 0; i < n_states; ++i) {
+    lanes[i] = i * n_classes;
+    lane_of[i] = i;
+  }
+  vector<int> merged_lane(n_states, -1);
+  vector<int> remap;
+  for (size_t i = 0; i < len; i += MERGE_INTERVAL) {
+    size_t end = std::min(len, i + MERGE_INTERVAL);
+    for (size_t k = i; k < end; ++k) {
+      state c = symbol_classes[p[k]];
+      for (size_t l = 0; l < lanes.size(); ++l)
+        lanes[l] = table[lanes[l] + c];
+    }
+    if (lanes.size() == 1) {
+      lanes[0] = run(lanes[0], str + end, len - end);
+      break;
+    }
+    // Merge lanes which reached the same state
+    remap.resize(lanes.size());
+    size_t n_lanes = 0;
+    for (size_t l = 0; l < lanes.size(); ++l) {
+      int &merged = merged_lane[lanes[l] / n_classes];
+      if (merged < 0) {
+        merged = n_lanes;
+        lanes[n_lanes++] = lanes[l];
+      }
+      remap[l] = merged;
+    }
+    for (size_t l = 0; l < n_lanes; ++l) merged_lane[lanes[l] / n_classes] = -1;
+    lanes.resize(n_lanes);
+    for (int s = 0; s < n_states; ++s) lane_of[s] = remap[lane_of[s]];
+  }
+  mapping->resize(n_states);
+  for (int s = 0; s < n_states; ++s) (*mapping)[s] = lanes[lane_of[s]];
+}
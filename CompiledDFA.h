@@ -0,0 +1,369 @@
+//
+// CompiledDFA.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef COMPILED_DFA_H_
+#define COMPILED_DFA_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "./DFA.h"
+#include "./MappedFile.h"
+
+class ThreadPool;
+
+using std::string;
+using std::vector;
+
+/**
+ Compiled (table driven) form of a DFA.
+
+ Every byte is first mapped to a symbol class by a 256 entry table, then the
+ next state is read from a single row-major transition table. States are kept
+ as row offsets (state * n_classes) so that a step costs two loads:
+
+     q = transitions[q + classes[byte]]
+
+ Bytes outside of the alphabet and missing transitions (DFA::NO_STATE) lead to
+ an extra non-accepting dead state which loops on itself.
+
+ The tables are laid out exactly as in the binary file written by save(), so
+ a saved DFA is loaded by memory-mapping the file and used in place: nothing
+ is parsed or copied, and processes loading the same file share its pages.
+ File layout (native byte order, every table aligned to 64 bytes):
+ - header: magic, version, byte order mark, states, symbol classes, start
+   and dead state, table offsets, file size and FNV-1a checksum of the whole
+   file (taken with the checksum field zeroed)
+ - 256 symbol classes, i.e. the alphabet map
+ - transition table
+ - accept bitmap
+ */
+class CompiledDFA {
+ public:
+  /**
+   Constructor.
+   @param dfa DFA to compile, changes made to it later are not reflected
+   */
+  explicit CompiledDFA(const DFA &dfa);
+
+  /**
+   Constructor from raw tables, e.g. of an automaton determinized over symbol
+   classes of its own.
+   @param symbol_classes Symbol class of each of the 256 bytes
+   @param n_classes Total symbol classes
+   @param n_states Total states, the dead state is added after them
+   @param transitions Row-major table of n_states * n_classes state numbers,
+                      DFA::NO_STATE leads to the dead state
+   @param start_state Start state
+   @param accepting_states Whether each state is accepting
+   */
+  CompiledDFA(const state *symbol_classes, int n_classes, int n_states,
+              const vector<state> &transitions, state start_state,
+              const vector<bool> &accepting_states);
+
+  /**
+   Constructor, loads a DFA written by save(). Use is_valid() to check whether
+   loading was successful.
+   @param path Path to the file, which is memory-mapped
+   @param verify Whether to verify the checksum and every transition, which
+                 reads the whole file. Skip only for trusted files.
+   */
+  explicit CompiledDFA(const char *path, bool verify = true);
+
+  /**
+   Copy constructor.
+   @param other Compiled DFA to copy, a loaded file is shared instead
+   */
+  CompiledDFA(const CompiledDFA &other);
+
+  /**
+   Assignment operator.
+   @param other Compiled DFA to copy, a loaded file is shared instead
+   */
+  CompiledDFA &operator=(const CompiledDFA &other);
+
+  /**
+   Whether the DFA is usable, i.e. it was not loaded from a missing, corrupt or
+   incompatible file.
+   @return True if valid, false otherwise
+   */
+  bool is_valid() const { return transitions != NULL; }
+
+  /**
+   Write the DFA in the binary format.
+   @param path Path to the file
+   @return True on success, false otherwise
+   */
+  bool save(const char *path) const;
+
+  /**
+   Evaluate the given string.
+   @param str String to evaluate
+   @return True on accepted, false on rejected
+   */
+  bool evaluate(const string &str) const {
+    return evaluate(str.data(), str.size());
+  }
+
+  /**
+   Evaluate the given bytes.
+   @param str Bytes to evaluate
+   @param len Total bytes
+   @return True on accepted, false on rejected
+   */
+  bool evaluate(const char *str, size_t len) const {
+    return is_accepting_state(run(start_state, str, len));
+  }
+
+  /**
+   Evaluate many independent strings at once.
+
+   Strings are advanced in lockstep, `width` at a time, so that the table
+   lookups of different strings overlap instead of waiting on each other. A
+   lane picks up the next string as soon as its current one ends.
+   @param strs Strings to evaluate
+   @param accepted Output bitmap, bit i (of word i / 64) is set if strs[i] is
+                   accepted
+   @param width Total lanes: 1, 2, 4, 8 or 16
+   @param simd Whether to use AVX2 gathers for the lookups, only with width 8
+               on builds where __AVX2__ is defined
+   */
+  void evaluate_batch(const vector<string> &strs, vector<uint64_t> *accepted,
+                      int width = 8, bool simd = false) const;
+
+  /**
+   Evaluate many independent strings spread over the threads of a pool.
+
+   Each thread evaluates chunks of strings using the lanes of
+   evaluate_batch(), stealing chunks from the others once done with its own.
+   Every thread reads the same tables and writes whole words of the bitmap,
+   so nothing is copied or locked.
+   @param strs Strings to evaluate
+   @param accepted Output bitmap, as for evaluate_batch()
+   @param pool Thread pool
+   */
+  void evaluate_batch(const vector<string> &strs, vector<uint64_t> *accepted,
+                      ThreadPool *pool) const;
+
+  /**
+   Evaluate every line of a file as an independent string, spread over the
+   threads of a pool. The file is memory-mapped, lines are evaluated in place
+   and exclude their `\n`, a last line without it is evaluated too.
+   @param path Path to the file
+   @param pool Thread pool
+   @param accepted Output bitmap, bit i (of word i / 64) is set if line i is
+                   accepted
+   @param n_lines Output: total lines
+   @return True on success, false if the file could not be mapped
+   */
+  bool evaluate_lines(const char *path, ThreadPool *pool,
+                      vector<uint64_t> *accepted, size_t *n_lines) const;
+
+  /**
+   Evaluate a single large input using multiple threads.
+
+   The input is split into one chunk per thread. The first chunk is run from
+   the start state, every other chunk is run from all states at once (lanes
+   reaching the same state are merged) giving a state to state mapping, and
+   the mappings are composed afterwards. DFAs having more than
+   MAX_ENUMERATED_STATES states instead run a chunk from a speculated state,
+   i.e. the state reached by the bytes right before the chunk, and re-run it
+   if the speculation was wrong. The result is always the same as evaluate().
+   The threads are those of a pool started for this call only, see the
+   overload taking a pool for evaluating many inputs.
+   @param str Bytes to evaluate
+   @param len Total bytes
+   @param n_threads Total threads, zero for the number of cores
+   @return True on accepted, false on rejected
+   */
+  bool evaluate_parallel(const char *str, size_t len, int n_threads = 0) const;
+
+  /**
+   Evaluate a single large input using the threads of a pool, one chunk per
+   thread, as evaluate_parallel() does with a pool of its own.
+   @param str Bytes to evaluate
+   @param len Total bytes
+   @param pool Thread pool
+   @return True on accepted, false on rejected
+   */
+  bool evaluate_parallel(const char *str, size_t len, ThreadPool *pool) const;
+
+  /**
+   Evaluate a single large string using multiple threads.
+   @param str String to evaluate
+   @param n_threads Total threads, zero for the number of cores
+   @return True on accepted, false on rejected
+   */
+  bool evaluate_parallel(const string &str, int n_threads = 0) const {
+    return evaluate_parallel(str.data(), str.size(), n_threads);
+  }
+
+  /**
+   Evaluate a single large string using the threads of a pool.
+   @param str String to evaluate
+   @param pool Thread pool
+   @return True on accepted, false on rejected
+   */
+  bool evaluate_parallel(const string &str, ThreadPool *pool) const {
+    return evaluate_parallel(str.data(), str.size(), pool);
+  }
+
+  /**
+   Run the given bytes from every state.
+   @param str Bytes to consume
+   @param len Total bytes
+   @param mapping Output: state (row offset) reached from each state number
+   */
+  void run_all(const char *str, size_t len, vector<state> *mapping) const;
+
+  /**
+   Run the given bytes from some state.
+   @param q Current state (row offset)
+   @param str Bytes to consume
+   @param len Total bytes
+   @return State (row offset) after consuming all the bytes
+   */
+  state run(state q, const char *str, size_t len) const;
+
+  /**
+   Transition function.
+   @param q Current state (row offset)
+   @param e Input byte
+   @return Next state (row offset)
+   */
+  state tf(state q, unsigned char e) const {
+    return transitions[q + symbol_classes[e]];
+  }
+
+  /**
+   Find if the given state is an accepting state.
+   @param q State (row offset) to check for
+   @return True if given state is an accepting state, false otherwise
+   */
+  bool is_accepting_state(state q) const {
+    q /= n_classes;
+    return (accepting_states[q >> 6] >> (q & 63)) & 1;
+  }
+
+  /**
+   Get start state.
+   @return Start state (row offset)
+   */
+  state get_start_state() const { return start_state; }
+
+  /**
+   Get dead state, i.e. the state reached by rejected bytes.
+   @return Dead state (row offset)
+   */
+  state get_dead_state() const { return dead_state; }
+
+  /**
+   Get total states, including the dead state.
+   @return Total states
+   */
+  int get_n_states() const { return n_states; }
+
+  /**
+   Get total symbol classes, i.e. the width of a row.
+   @return Total symbol classes
+   */
+  int get_n_classes() const { return n_classes; }
+
+  /**
+   Find the states which can reach an accepting state, the dead state never
+   can.
+   @param live Output: whether each state number is live
+   */
+  void find_live_states(vector<bool> *live) const;
+
+  /**
+   Get symbol class of a byte.
+   @param e Input byte
+   @return Symbol class (column index)
+   */
+  int get_symbol_class(unsigned char e) const { return symbol_classes[e]; }
+
+  /**
+   Get the transition table, useful for the other backends.
+   @return Row-major transition table of row offsets
+   */
+  const state *get_transitions() const { return transitions; }
+
+ private:
+  // States above which evaluate_parallel() speculates instead of enumerating
+  static const int MAX_ENUMERATED_STATES = 256;
+
+  /**
+   Evaluate many independent strings using a fixed number of lanes.
+   @param strs Strings to evaluate
+   @param first First string to evaluate
+   @param last String after the last one to evaluate
+   @param accepted Output bitmap, already zeroed
+   */
+  template <int WIDTH>
+  void evaluate_lanes(const vector<string> &strs, size_t first, size_t last,
+                      vector<uint64_t> *accepted) const;
+
+  /**
+   Evaluate many independent strings using AVX2 gathers.
+   @param strs Strings to evaluate
+   @param accepted Output bitmap, already zeroed
+   */
+  void evaluate_gather(const vector<string> &strs,
+                       vector<uint64_t> *accepted) const;
+
+  /**
+   Lay out the file image of a DFA and point the tables to it.
+   @param classes Symbol class of each of the 256 bytes
+   @param width Total symbol classes
+   @param n_dfa_states Total states but the dead state
+   @param rows Row-major transition table of state numbers, DFA::NO_STATE
+               leads to the dead state
+   @param start Start state
+   @param accepting Whether each state is accepting
+   */
+  void compile(const state *classes, int width, int n_dfa_states,
+               const vector<state> &rows, state start,
+               const vector<bool> &accepting);
+
+  /**
+   Point the tables to a file image and read the header.
+   @param base First byte of the image
+   */
+  void attach(const char *base);
+
+  // Accept bitmap indexed by state number
+  const uint64_t *accepting_states;
+
+  // Dead state (row offset)
+  state dead_state;
+
+  // Total symbol classes
+  int n_classes;
+
+  // Total states including the dead state
+  int n_states;
+
+  // Start state (row offset)
+  state start_state;
+
+  // Byte to symbol class map
+  const state *symbol_classes;
+
+  // Transition table: row-major, values are row offsets, NULL if invalid
+  const state *transitions;
+
+  // File image the tables point to, when compiled from a DFA
+  vector<uint64_t> image;
+
+  // Mapped file the tables point to, when loaded from a file
+  std::shared_ptr<MappedFile> mapping;
+};
+
+#endif  // COMPILED_DFA_H_
@@ -0,0 +1,59 @@
+//
+// CompiledDFA_example.cpp
+// FiniteAutomataLabExperiments
+//
+// Save the compiled DFA matching strings with substring `011` to a file, load
+// it back (memory-mapped, no parsing) and match strings with it, `-1` to exit
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "CompiledDFA.h"
+#include "DFA.h"
+
+using std::cin;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+int main(int argc, char *argv[]) {
+  const char *path = argc > 1 ? argv[1] : "str_011.dfa";
+  vector<state> accepting_states;
+  accepting_states.push_back(3);
+  vector<input_symbol> input_symbols;
+  input_symbols.push_back('0');
+  input_symbols.push_back('1');
+  DFA str_011(4, input_symbols, 0, accepting_states);
+  str_011.set_state(0, '0', 1);
+  str_011.set_state(0, '1', 0);
+  str_011.set_state(1, '0', 1);
+  str_011.set_state(1, '1', 2);
+  str_011.set_state(2, '0', 1);
+  str_011.set_state(2, '1', 3);
+  str_011.set_state(3, '0', 3);
+  str_011.set_state(3, '1', 3);
+  if (!CompiledDFA(str_011).save(path)) {
+    cout << "Cannot write " << path << endl;
+    return 1;
+  }
+
+  CompiledDFA loaded(path);
+  if (!loaded.is_valid()) {
+    cout << "Cannot load " << path << endl;
+    return 1;
+  }
+  cout << "Loaded " << path << ": " << loaded.get_n_states() << " states, "
+       << loaded.get_n_classes() << " symbol classes\n" << endl;
+
+  string str;
+  while (true) {
+    cout << "Enter a string: "; cin >> str;
+    if (str == "-1") break;
+    bool status = loaded.evaluate(str);
+    cout << "Status: " << (status ? "Accepted" : "Rejected") << "\n" << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,196 @@
+//
+// CompressedDFA.cpp
+// FiniteAutomataLabExperiments
+//
+
+#include "./CompressedDFA.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+using std::map;
+using std::vector;
+
+const state CompressedDFA::NO_ROW = static_cast<state>(-1);
+
+// Constructor.
+CompressedDFA::CompressedDFA(const DFA &dfa, Layout layout)
+    : layout(layout) {
+  std::shared_ptr<CompiledDFA> compiled(new CompiledDFA(dfa));
+  n_classes = compiled->get_n_classes();
+  n_states = compiled->get_n_states();
+  start_state = compiled->get_start_state() / n_classes;
+  for (int b = 0; b < 256; ++b)
+    symbol_classes[b] = compiled->get_symbol_class(b);
+  accepting_states.assign((n_states + 63) / 64, 0);
+  for (int i = 0; i < n_states; ++i)
+    if (compiled->is_accepting_state(i * n_classes))
+      accepting_states[i >> 6] |= static_cast<uint64_t>(1) << (i & 63);
+  if (layout != LAYOUT_DENSE) compress(*compiled);
+  // The packing may leave more unused entries than estimated
+  if (layout == LAYOUT_AUTO &&
+      get_memory_usage() * AUTO_RATIO > get_dense_memory_usage()) {
+    this->layout = LAYOUT_DENSE;
+  }
+  if (this->layout == LAYOUT_DENSE) {
+    dense = compiled;
+    vector<state>().swap(rows);
+    vector<state>().swap(defaults);
+    vector<state>().swap(bases);
+    vector<Entry>().swap(entries);
+  }
+}
+
+// Compress the transition table of a compiled DFA.
+void CompressedDFA::compress(const CompiledDFA &compiled) {
+  const state *table = compiled.get_transitions();
+  // Deduplicate the rows, targets are converted to state numbers
+  map< vector<state>, state > row_ids;
+  vector< vector<state> > unique_rows;
+  rows.resize(n_states);
+  vector<state> row(n_classes);
+  for (int i = 0; i < n_states; ++i) {
+    for (int c = 0; c < n_classes; ++c)
+      row[c] = table[static_cast<size_t>(i) * n_classes + c] / n_classes;
+    map< vector<state>, state >::iterator it = row_ids.find(row);
+    if (it == row_ids.end()) {
+      it = row_ids.insert(std::make_pair(row, unique_rows.size())).first;
+      unique_rows.push_back(row);
+    }
+    rows[i] = it->second;
+  }
+  // Default transition of each row is its most common target, the rest are
+  // its exceptions
+  int n_rows = unique_rows.size();
+  defaults.resize(n_rows);
+  vector< vector<int> > exceptions(n_rows);
+  size_t n_exceptions = 0;
+  vector<state> sorted(n_classes);
+  for (int r = 0; r < n_rows; ++r) {
+    sorted = unique_rows[r];
+    std::sort(sorted.begin(), sorted.end());
+    state best = sorted[0];
+    int best_count = 0;
+    for (int c = 0; c < n_classes; ) {
+      int d = c;
+      while (d < n_classes && sorted[d] == sorted[c]) ++d;
+      if (d - c > best_count) {
+        best = sorted[c];
+        best_count = d - c;
+      }
+      c = d;
+    }
+    defaults[r] = best;
+    for (int c = 0; c < n_classes; ++c)
+      if (unique_rows[r][c] != best) exceptions[r].push_back(c);
+    n_exceptions += exceptions[r].size();
+  }
+  // Decide the layout from the least size the compressed one may have
+  if (layout == LAYOUT_AUTO) {
+    size_t least = rows.size() * sizeof(state) +
+                   defaults.size() * 2 * sizeof(state) +
+                   n_exceptions * sizeof(Entry);
+    size_t table_size =
+        static_cast<size_t>(n_states) * n_classes * sizeof(state);
+    layout = (least * AUTO_RATIO <= table_size ? LAYOUT_COMPRESSED
+                                               : LAYOUT_DENSE);
+    if (layout == LAYOUT_DENSE) return;
+  }
+  // Pack the rows having most exceptions first, each row at the first base
+  // whose entries are free, entries past the end being free
+  vector<int> order(n_rows);
+  for (int r = 0; r < n_rows; ++r) order[r] = r;
+  std::stable_sort(order.begin(), order.end(), [&exceptions](int a, int b) {
+    return exceptions[a].size() > exceptions[b].size();
+  });
+  bases.assign(n_rows, 0);
+  entries.clear();
+  Entry unused = { NO_ROW, 0 };
+  // Free entries before `first_free` are given up on, it only moves forward
+  size_t first_free = 0, last_base = 0;
+  for (int k = 0; k < n_rows; ++k) {
+    int r = order[k];
+    const vector<int> &columns = exceptions[r];
+    if (columns.empty()) break;
+    while (first_free < entries.size() &&
+           entries[first_free].row != NO_ROW) {
+      ++first_free;
+    }
+    // Try bases which put the first exception on a free entry. After a few
+    // failed tries the free entries before it are given up on, which keeps
+    // the packing about linear.
+    size_t base = first_free > columns[0] ? first_free - columns[0] : 0;
+    for (int tries = 0; ; ++base) {
+      if (base + columns[0] >= entries.size()) break;
+      if (entries[base + columns[0]].row != NO_ROW) continue;
+      if (++tries == MAX_BASE_TRIES) {
+        first_free = base + columns[0];
+        tries = 0;
+      }
+      int j = 1;
+      while (j < columns.size() && (base + columns[j] >= entries.size() ||
+                                    entries[base + columns[j]].row == NO_ROW))
+        ++j;
+      if (j == columns.size()) break;
+    }
+    if (base + columns.back() >= entries.size())
+      entries.resize(base + columns.back() + 1, unused);
+    bases[r] = base;
+    last_base = std::max(last_base, base);
+    for (int j = 0; j < columns.size(); ++j) {
+      entries[base + columns[j]].row = r;
+      entries[base + columns[j]].next = unique_rows[r][columns[j]];
+    }
+  }
+  // Every entry reachable by base + class has to exist
+  entries.resize(std::max(entries.size(), last_base + n_classes), unused);
+  layout = LAYOUT_COMPRESSED;
+}
+
+// Run the given bytes from some state.
+state CompressedDFA::run(state q, const char *str, size_t len) const {
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(str);
+  const unsigned char *end = p + len;
+  if (dense) {
+    int width = n_classes;
+    return dense->run(q * width, str, len) / width;
+  }
+  const state *rows = &this->rows[0];
+  const state *bases = &this->bases[0];
+  const state *defaults = &this->defaults[0];
+  const Entry *entries = &this->entries[0];
+  const state *symbol_classes = this->symbol_classes;
+  for ( ; p != end; ++p) {
+    state r = rows[q];
+    const Entry &entry = entries[bases[r] + symbol_classes[*p]];
+    q = (entry.row == r ? entry.next : defaults[r]);
+  }
+  return q;
+}
+
+// Transition function.
+state CompressedDFA::tf(state q, unsigned char e) const {
+  if (dense) {
+    int width = n_classes;
+    return dense->tf(q * width, e) / width;
+  }
+  state r = rows[q];
+  const Entry &entry = entries[bases[r] + symbol_classes[e]];
+  return (entry.row == r ? entry.next : defaults[r]);
+}
+
+// Get memory used by the transition tables and the accept bitmap.
+size_t CompressedDFA::get_memory_usage() const {
+  if (dense) return get_dense_memory_usage();
+  return accepting_states.size() * sizeof(uint64_t) + sizeof(symbol_classes) +
+         rows.size() * sizeof(state) + bases.size() * sizeof(state) +
+         defaults.size() * sizeof(state) + entries.size() * sizeof(Entry);
+}
+
+// Get memory the dense layout uses (or would use) for the same DFA.
+size_t CompressedDFA::get_dense_memory_usage() const {
+  return accepting_states.size() * sizeof(uint64_t) + sizeof(symbol_classes) +
+         static_cast<size_t>(n_states) * n_classes * sizeof(state);
+}
@@ -0,0 +1,213 @@
+//
+// CompressedDFA.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef COMPRESSED_DFA_H_
+#define COMPRESSED_DFA_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "./CompiledDFA.h"
+#include "./DFA.h"
+
+using std::string;
+using std::vector;
+
+/**
+ DFA having a compressed transition table, for large DFAs whose rows repeat.
+
+ Bytes are mapped to symbol classes as in CompiledDFA, then the transition
+ table is compressed in three steps:
+ - row deduplication: states having identical rows share one row
+ - default transitions: each row keeps its most common target as the default
+   and only lists the other transitions (exceptions)
+ - comb-vector packing (row displacement): the exceptions of all rows are
+   packed into one table, row r being placed at offset base[r] so that its
+   exceptions fall into entries not used by other rows. Each entry keeps the
+   row it belongs to, so a step is:
+
+       r = rows[q], i = base[r] + class
+       q = entries[i].row == r ? entries[i].next : defaults[r]
+
+ The compressed layout costs a few more loads per byte than the dense one of
+ CompiledDFA, so by default it is only used when it is at most half the size.
+ States are numbered as in the DFA, plus a dead state reached by bytes outside
+ of the alphabet and by missing transitions.
+ */
+class CompressedDFA {
+ public:
+  /**
+   Layouts of the transition table.
+   */
+  enum Layout {
+    // Compressed if it is at most 1 / AUTO_RATIO the size of dense
+    LAYOUT_AUTO,
+    // Dense table, i.e. CompiledDFA
+    LAYOUT_DENSE,
+    // Deduplicated rows, default transitions and comb-vector packing
+    LAYOUT_COMPRESSED
+  };
+
+  // Least ratio of dense to compressed size for LAYOUT_AUTO to compress
+  static const int AUTO_RATIO = 2;
+
+  /**
+   Constructor.
+   @param dfa DFA to compile, changes made to it later are not reflected
+   @param layout Layout of the transition table
+   */
+  explicit CompressedDFA(const DFA &dfa, Layout layout = LAYOUT_AUTO);
+
+  /**
+   Evaluate the given string.
+   @param str String to evaluate
+   @return True on accepted, false on rejected
+   */
+  bool evaluate(const string &str) const {
+    return evaluate(str.data(), str.size());
+  }
+
+  /**
+   Evaluate the given bytes.
+   @param str Bytes to evaluate
+   @param len Total bytes
+   @return True on accepted, false on rejected
+   */
+  bool evaluate(const char *str, size_t len) const {
+    return is_accepting_state(run(start_state, str, len));
+  }
+
+  /**
+   Run the given bytes from some state.
+   @param q Current state
+   @param str Bytes to consume
+   @param len Total bytes
+   @return State after consuming all the bytes
+   */
+  state run(state q, const char *str, size_t len) const;
+
+  /**
+   Transition function.
+   @param q Current state
+   @param e Input byte
+   @return Next state
+   */
+  state tf(state q, unsigned char e) const;
+
+  /**
+   Find if the given state is an accepting state.
+   @param q State to check for
+   @return True if given state is an accepting state, false otherwise
+   */
+  bool is_accepting_state(state q) const {
+    return (accepting_states[q >> 6] >> (q & 63)) & 1;
+  }
+
+  /**
+   Get start state.
+   @return Start state
+   */
+  state get_start_state() const { return start_state; }
+
+  /**
+   Get dead state, i.e. the state reached by rejected bytes.
+   @return Dead state
+   */
+  state get_dead_state() const { return n_states - 1; }
+
+  /**
+   Get total states, including the dead state.
+   @return Total states
+   */
+  int get_n_states() const { return n_states; }
+
+  /**
+   Get total symbol classes.
+   @return Total symbol classes
+   */
+  int get_n_classes() const { return n_classes; }
+
+  /**
+   Get the layout in use, never LAYOUT_AUTO.
+   @return Layout
+   */
+  Layout get_layout() const { return layout; }
+
+  /**
+   Get total distinct rows of the compressed layout.
+   @return Total distinct rows, zero for the dense layout
+   */
+  int get_n_rows() const { return defaults.size(); }
+
+  /**
+   Get memory used by the transition tables and the accept bitmap.
+   @return Total bytes
+   */
+  size_t get_memory_usage() const;
+
+  /**
+   Get memory the dense layout uses (or would use) for the same DFA.
+   @return Total bytes
+   */
+  size_t get_dense_memory_usage() const;
+
+ private:
+  // Entry of the comb-vector: row it belongs to (NO_ROW if unused) and target
+  struct Entry {
+    state row;
+    state next;
+  };
+
+  // Row of the unused entries
+  static const state NO_ROW;
+
+  // Maximum bases tried for a row before it is placed after every other row
+  static const int MAX_BASE_TRIES = 64;
+
+  /**
+   Compress the transition table of a compiled DFA.
+   @param compiled Compiled DFA
+   */
+  void compress(const CompiledDFA &compiled);
+
+  // Accept bitmap indexed by state
+  vector<uint64_t> accepting_states;
+
+  // Comb-vector: base of each row
+  vector<state> bases;
+
+  // Default transition of each row
+  vector<state> defaults;
+
+  // Dense layout, NULL for the compressed layout
+  std::shared_ptr<CompiledDFA> dense;
+
+  // Comb-vector: packed exceptions of all rows
+  vector<Entry> entries;
+
+  // Layout in use
+  Layout layout;
+
+  // Total symbol classes
+  int n_classes;
+
+  // Total states including the dead state
+  int n_states;
+
+  // Row of each state
+  vector<state> rows;
+
+  // Start state
+  state start_state;
+
+  // Byte to symbol class map
+  state symbol_classes[256];
+};
+
+#endif  // COMPRESSED_DFA_H_
@@ -9,14 +9,20 @@
 #include "./DFA.h"
 
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "./Stats.h"
+
 using std::cout;
 using std::endl;
 using std::string;
 using std::vector;
 
+// Init NO_STATE
+const state DFA::NO_STATE = static_cast<state>(-1);
+
 // Constructor.
 DFA::DFA(int n_states, const vector<input_symbol> &input_symbols,
          state start_state, const vector<state> &accepting_states)
@@ -28,38 +34,281 @@ DFA::DFA(int n_states, const vector<input_symbol> &input_symbols,
     vector< state > t_row(n_input_symbols);
     transition_table.push_back(t_row);
   }
+  accepting.assign(this->n_states, false);
+  for (int i = 0; i < accepting_states.size(); ++i)
+    if (accepting_states[i] < this->n_states)
+      accepting[accepting_states[i]] = true;
+  // The last duplicate wins, as with the former linear lookup
+  for (int e = 0; e < 256; ++e) symbol_index[e] = -1;
+  for (int j = 0; j < n_input_symbols; ++j)
+    symbol_index[static_cast<unsigned char>(input_symbols[j])] = j;
 }
 
 // Evaluate the given string.
-bool DFA::evaluate(const string &str, bool print_states) {
-  reset_current_state();
+bool DFA::evaluate(const string &str, bool print_states) const {
+  FA_STATS_COUNT("dfa.evaluate.calls", 1);
+  FA_STATS_COUNT("dfa.evaluate.symbols", str.length());
+  state q = start_state;
   if (print_states) cout << "Transitions: ";
   for (int i = 0; i < str.length(); ++i) {
-    if (print_states) cout << " -> q" << get_current_state();
-    tf(get_current_state(), str[i]);
+    if (print_states) cout << " -> q" << q;
+    // Symbol outside of the alphabet or missing transition
+    if ((q = tf(q, str[i])) == NO_STATE) {
+      if (print_states) cout << " -> (dead)" << endl;
+      return false;
+    }
+  }
+  if (print_states) cout << " -> q" << q << endl;
+  return is_accepting_state(q);
+}
+
+// Search the given string for substrings accepted by the DFA.
+bool DFA::search(const string &str, SearchMode mode,
+                 vector<Match> *matches) const {
+  std::shared_ptr<const vector<bool> > live = std::atomic_load(&live_states);
+  if (!live) {
+    // Racing searches may each find it, they all get the same result
+    live = find_live_states();
+    std::atomic_store(&live_states, live);
   }
-  if (print_states) cout << " -> q" << get_current_state() << endl;
-  return is_accepting_state();
+  const vector<bool> &live_state = *live;
+  return search_threads(str.size(), mode, n_states,
+      [&](SearchSet *set, size_t offset) {
+        if (live_state[start_state]) set->add(start_state, offset);
+      },
+      [&](const SearchSet &from, size_t offset, SearchSet *to) {
+        int j = get_index_by_input_symbol(str[offset]);
+        // Symbol outside of the alphabet
+        if (j < 0) return;
+        for (int i = 0; i < from.size(); ++i) {
+          state s = transition_table[from.get_state(i)][j];
+          if (s != NO_STATE && live_state[s]) to->add(s, from.get_start(i));
+        }
+      },
+      [&](state q) { return accepting[q]; }, matches);
 }
 
-// Get index by input symbol.
-int DFA::get_index_by_input_symbol(input_symbol e) {
-  int n = input_symbols.size();
-  while (n--)
-    if (e == input_symbols[n]) return n;
-  return -1;
+// Find the states which can reach an accepting state.
+std::shared_ptr<const vector<bool> > DFA::find_live_states() const {
+  vector< vector<state> > reverse(n_states);
+  for (int q = 0; q < n_states; ++q)
+    for (int j = 0; j < n_input_symbols; ++j)
+      if (transition_table[q][j] != NO_STATE)
+        reverse[transition_table[q][j]].push_back(q);
+  std::shared_ptr<vector<bool> > live(new vector<bool>(accepting));
+  vector<state> stack;
+  for (int q = 0; q < n_states; ++q)
+    if (accepting[q]) stack.push_back(q);
+  while (!stack.empty()) {
+    state q = stack.back();
+    stack.pop_back();
+    for (int i = 0; i < reverse[q].size(); ++i) {
+      if (!(*live)[reverse[q][i]]) {
+        (*live)[reverse[q][i]] = true;
+        stack.push_back(reverse[q][i]);
+      }
+    }
+  }
+  return live;
+}
+
+// Minimize the DFA using Hopcroft's partition refinement algorithm.
+DFA DFA::minimize() const {
+  // Reachable states
+  vector<bool> reachable(n_states, false);
+  vector<state> order(1, start_state);
+  reachable[start_state] = true;
+  for (int i = 0; i < order.size(); ++i) {
+    for (int j = 0; j < n_input_symbols; ++j) {
+      state s = transition_table[order[i]][j];
+      if (s != NO_STATE && !reachable[s]) {
+        reachable[s] = true;
+        order.push_back(s);
+      }
+    }
+  }
+  // Useful states, i.e. reachable states which can reach an accepting state
+  vector< vector<state> > reverse(n_states);
+  for (int i = 0; i < order.size(); ++i)
+    for (int j = 0; j < n_input_symbols; ++j)
+      if (transition_table[order[i]][j] != NO_STATE)
+        reverse[transition_table[order[i]][j]].push_back(order[i]);
+  vector<bool> useful(n_states, false);
+  vector<state> stack;
+  for (int i = 0; i < order.size(); ++i) {
+    if (accepting[order[i]]) {
+      useful[order[i]] = true;
+      stack.push_back(order[i]);
+    }
+  }
+  while (!stack.empty()) {
+    state q = stack.back();
+    stack.pop_back();
+    for (int i = 0; i < reverse[q].size(); ++i) {
+      if (!useful[reverse[q][i]]) {
+        useful[reverse[q][i]] = true;
+        stack.push_back(reverse[q][i]);
+      }
+    }
+  }
+  if (!useful[start_state]) {
+    // Empty language: a single rejecting state
+    return DFA(1, input_symbols, 0, vector<state>());
+  }
+
+  // Complete automaton over the useful states plus a sink (the last state)
+  vector<int> index(n_states, -1);
+  int n = 0;
+  for (int i = 0; i < order.size(); ++i)
+    if (useful[order[i]]) index[order[i]] = n++;
+  int sink = n++;
+  vector<state> original(n);
+  for (int q = 0; q < n_states; ++q)
+    if (index[q] >= 0) original[index[q]] = q;
+  vector<int> delta(n * n_input_symbols, sink);
+  for (int i = 0; i < order.size(); ++i) {
+    if (!useful[order[i]]) continue;
+    for (int j = 0; j < n_input_symbols; ++j) {
+      state s = transition_table[order[i]][j];
+      if (s != NO_STATE && useful[s])
+        delta[index[order[i]] * n_input_symbols + j] = index[s];
+    }
+  }
+  // Inverse transitions per input symbol: preimage[a][head[a][t]..] are the
+  // states going to t on a
+  vector< vector<int> > head(n_input_symbols, vector<int>(n + 1, 0));
+  vector< vector<int> > preimage(n_input_symbols, vector<int>(n));
+  for (int a = 0; a < n_input_symbols; ++a) {
+    for (int q = 0; q < n; ++q) ++head[a][delta[q * n_input_symbols + a] + 1];
+    for (int t = 0; t < n; ++t) head[a][t + 1] += head[a][t];
+    vector<int> fill(head[a].begin(), head[a].end() - 1);
+    for (int q = 0; q < n; ++q)
+      preimage[a][fill[delta[q * n_input_symbols + a]]++] = q;
+  }
+
+  // Partition: block b holds elems[first[b]..last[b]), its first marked[b]
+  // elements are marked
+  vector<int> elems(n), loc(n), block(n);
+  vector<int> first, last, marked;
+  for (int pass = 0, k = 0; pass < 2; ++pass) {
+    int start = k;
+    for (int q = 0; q < n; ++q) {
+      if ((q != sink && accepting[original[q]]) == (pass == 0)) {
+        elems[k] = q;
+        loc[q] = k++;
+        block[q] = first.size();
+      }
+    }
+    if (k > start) {
+      first.push_back(start);
+      last.push_back(k);
+      marked.push_back(0);
+    }
+  }
+  // Either block is enough as the first splitter
+  vector<int> worklist(1, 0);
+  vector<int> splitter, touched;
+  while (!worklist.empty()) {
+    int b = worklist.back();
+    worklist.pop_back();
+    splitter.assign(elems.begin() + first[b], elems.begin() + last[b]);
+    for (int a = 0; a < n_input_symbols; ++a) {
+      // Mark the preimage of the splitter
+      for (int i = 0; i < splitter.size(); ++i) {
+        int t = splitter[i];
+        for (int p = head[a][t]; p < head[a][t + 1]; ++p) {
+          int q = preimage[a][p];
+          int y = block[q];
+          int pos = first[y] + marked[y]++;
+          if (pos == first[y]) touched.push_back(y);
+          int other = elems[pos];
+          elems[pos] = q;
+          elems[loc[q]] = other;
+          loc[other] = loc[q];
+          loc[q] = pos;
+        }
+      }
+      // Split every touched block into its marked and unmarked part
+      for (int i = 0; i < touched.size(); ++i) {
+        int y = touched[i];
+        int mid = first[y] + marked[y];
+        marked[y] = 0;
+        if (mid == last[y]) continue;
+        int z = first.size();
+        // The new block z takes the smaller part
+        if (mid - first[y] <= last[y] - mid) {
+          first.push_back(first[y]);
+          last.push_back(mid);
+          first[y] = mid;
+        } else {
+          first.push_back(mid);
+          last.push_back(last[y]);
+          last[y] = mid;
+        }
+        marked.push_back(0);
+        for (int p = first[z]; p < last[z]; ++p) block[elems[p]] = z;
+        // If y is still to be processed both parts are, otherwise the
+        // smaller part is enough: either way z has to be added
+        worklist.push_back(z);
+      }
+      touched.clear();
+    }
+  }
+
+  // Number the blocks in breadth-first order from the start state
+  int n_blocks = first.size();
+  vector<int> number(n_blocks, -1);
+  vector<int> representative;
+  int sink_block = block[sink];
+  number[block[index[start_state]]] = 0;
+  representative.push_back(index[start_state]);
+  for (int i = 0; i < representative.size(); ++i) {
+    for (int a = 0; a < n_input_symbols; ++a) {
+      int t = block[delta[representative[i] * n_input_symbols + a]];
+      if (t != sink_block && number[t] < 0) {
+        number[t] = representative.size();
+        representative.push_back(elems[first[t]]);
+      }
+    }
+  }
+  vector<state> min_accepting_states;
+  for (int i = 0; i < representative.size(); ++i)
+    if (accepting[original[representative[i]]])
+      min_accepting_states.push_back(i);
+  DFA dfa(representative.size(), input_symbols, 0, min_accepting_states);
+  for (int i = 0; i < representative.size(); ++i) {
+    for (int a = 0; a < n_input_symbols; ++a) {
+      int t = block[delta[representative[i] * n_input_symbols + a]];
+      dfa.transition_table[i][a] = (t == sink_block ? NO_STATE : number[t]);
+    }
+  }
+  return dfa;
 }
 
-// Find if the given state is an accepting state.
-bool DFA::is_accepting_state(state q) {
-  int n = accepting_states.size();
-  while (n--)
-    if (q == accepting_states[n]) return true;
-  return false;
+// Complement the DFA with respect to its input symbols.
+DFA DFA::complement() const {
+  bool missing = false;
+  for (int q = 0; q < n_states; ++q)
+    for (int j = 0; j < n_input_symbols; ++j)
+      if (transition_table[q][j] == NO_STATE) missing = true;
+  // Sink state taking the missing transitions, only added if needed
+  state sink = n_states;
+  vector<state> complement_states;
+  for (int q = 0; q < n_states; ++q)
+    if (!accepting[q]) complement_states.push_back(q);
+  if (missing) complement_states.push_back(sink);
+  DFA dfa(n_states + missing, input_symbols, start_state, complement_states);
+  for (int q = 0; q < dfa.n_states; ++q) {
+    for (int j = 0; j < n_input_symbols; ++j) {
+      state s = q == sink ? NO_STATE : transition_table[q][j];
+      dfa.transition_table[q][j] = s == NO_STATE ? sink : s;
+    }
+  }
+  return dfa;
 }
 
 // Output transision table to the standard output, useful for debugging.
-void DFA::print_transition_table() {
+void DFA::print_transition_table() const {
   cout << "Transition Table\n       ";
   for (int j = 0; j < n_input_symbols; ++j)
     cout << " |  " << static_cast<char>(input_symbols[j]);
@@ -72,7 +321,11 @@ void DFA::print_transition_table() {
          << (is_accepting_state(i) ? "* ": "  ")
          << 'q' << i;
     for (int j = 0; j < n_input_symbols; ++j) {
-      cout << " | " << 'q' << tf(i, input_symbols[j]);
+      state s = tf(i, input_symbols[j]);
+      if (s == NO_STATE)
+        cout << " |  -";
+      else
+        cout << " | " << 'q' << s;
     }
     cout << " |\n";
   }
@@ -9,9 +9,12 @@
 #ifndef DFA_H_
 #define DFA_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "./Search.h"
+
 // Define types
 typedef unsigned int state;
 typedef char input_symbol;
@@ -26,6 +29,9 @@ using std::vector;
  */
 class DFA {
  public:
+  // Missing transition: any input reaching it is rejected
+  static const state NO_STATE;
+
   /**
    Constructor.
    @param n_states Total states
@@ -37,19 +43,55 @@ class DFA {
       state start_state, const vector<state> &accepting_states);
 
   /**
-   Evaluate the given string.
+   Evaluate the given string. The DFA is not modified, so any number of
+   threads may evaluate strings with it at once.
    @param str String evaluate
    @param print_states Whether to output states to the standard output
    @return True on accepted, false on rejected
    */
-  bool evaluate(const string &str, bool print_states = false);
+  bool evaluate(const string &str, bool print_states = false) const;
+
+  /**
+   Search the given string for substrings accepted by the DFA, i.e. a match may
+   start and end anywhere. Threads in states which can no longer reach an
+   accepting state are dropped, and scanning stops as soon as the answer is
+   known, see SearchMode.
+   @param str String to search
+   @param mode What to report
+   @param matches Output: matches in increasing end offset
+   @return True if there is a match, false otherwise
+   */
+  bool search(const string &str, SearchMode mode,
+              vector<Match> *matches) const;
+
+  /**
+   Minimize the DFA using Hopcroft's partition refinement algorithm.
+
+   States unreachable from the start state and dead states (which can never
+   reach an accepting state) are removed, transitions to them become
+   NO_STATE. States of the new DFA are numbered in breadth-first order from
+   the start state, which is always q0.
+   Runs in O(n k log n) for n states and k input symbols.
+   @return Equivalent DFA having the least number of states
+   */
+  DFA minimize() const;
+
+  /**
+   Complement the DFA with respect to its input symbols: the new DFA accepts
+   exactly the strings of input symbols this one rejects. Missing transitions
+   go to a new accepting sink state. Strings having a symbol outside of the
+   alphabet are still rejected, see ProductDFA for combining DFAs having
+   different alphabets.
+   @return Complement DFA, having the same start state
+   */
+  DFA complement() const;
 
   /**
    Output transision table to the standard output, useful for debugging.
 
    Start state has a `->` and accepting states have `*` beside them.
    */
-  void print_transition_table();
+  void print_transition_table() const;
 
   /**
    Insert data into transition table.
@@ -58,26 +100,77 @@ class DFA {
    @param s Destination state
    */
   void set_state(state q, input_symbol e, state s) {
-    transition_table[q][get_index_by_input_symbol(e)] = s;
+    int index = get_index_by_input_symbol(e);
+    if (index >= 0) transition_table[q][index] = s;
+    live_states.reset();
   }
 
   /**
-   Transition function.
+   Transition function. The caller keeps the current state, so this is also
+   the per-thread cursor of a DFA shared between threads:
+
+       state q = dfa.get_start_state();
+       for (...) q = dfa.tf(q, e);
+
+   Symbols outside of the alphabet lead to NO_STATE.
    @param q Current state
    @param e Input symbol from the current state
    @return Next state based on the input symbol
    */
-  state tf(state q, input_symbol e) {
-    return (current_state =
-            transition_table[q][get_index_by_input_symbol(e)]);
+  state tf(state q, input_symbol e) const {
+    int index = get_index_by_input_symbol(e);
+    return (q == NO_STATE || index < 0) ? NO_STATE :
+                                          transition_table[q][index];
+  }
+
+  /**
+   Get destination state by the index of an input symbol.
+   @param q Current state
+   @param index Index of input_symbols array
+   @return Next state
+   */
+  state get_transition(state q, int index) const {
+    return transition_table[q][index];
+  }
+
+  /**
+   Get input symbols.
+   @return Input symbols
+   */
+  const vector<input_symbol> &get_input_symbols() const {
+    return input_symbols;
+  }
+
+  /**
+   Get total states.
+   @return Total states
+   */
+  int get_n_states() const { return n_states; }
+
+  /**
+   Get start state.
+   @return Start state
+   */
+  state get_start_state() const { return start_state; }
+
+  /**
+   Find if the given state is an accepting state.
+   @param q State to check for
+   @return True if given state is an accepting state, false otherwise
+   */
+  bool is_accepting_state(state q) const {
+    return q < accepting.size() && accepting[q];
   }
 
  private:
   // Accepting states
   const vector< state > accepting_states;
 
-  // Current state for DFA::evaluate()
-  state current_state;
+  // Whether each state is accepting
+  vector<bool> accepting;
+
+  // Index in input_symbols of each byte, -1 if not an input symbol
+  int symbol_index[256];
 
   // Input symbols
   const vector<input_symbol> input_symbols;
@@ -94,36 +187,26 @@ class DFA {
   // Transition table
   vector< vector< state > > transition_table;
 
+  // Whether each state can reach an accepting state, NULL if not found yet.
+  // Found by search() and shared by the copies of the DFA, loaded and stored
+  // atomically since concurrent searches may find it at once; set_state()
+  // replaces it instead of modifying it.
+  mutable std::shared_ptr<const vector<bool> > live_states;
+
   /**
-   Get current state.
-   @return Current state
+   Find the states which can reach an accepting state, see live_states.
+   @return Whether each state is live
    */
-  state get_current_state() { return current_state; }
+  std::shared_ptr<const vector<bool> > find_live_states() const;
 
   /**
    Get index by input symbol.
    @param e Input symbol
-   @return Index of input_symbols array
+   @return Index of input_symbols array, -1 if not an input symbol
    */
-  int get_index_by_input_symbol(input_symbol e);
-
-  /**
-   Find if the current state is an accepting state.
-   @return True if current state is an accepting state, false otherwise
-   */
-  bool is_accepting_state() { return is_accepting_state(current_state); }
-
-  /**
-   Find if the given state is an accepting state.
-   @param q State to check for
-   @return True if given state is an accepting state, false otherwise
-   */
-  bool is_accepting_state(state q);
-
-  /**
-   Reset current state, i.e. set current state to start state.
-   */
-  void reset_current_state() { current_state = start_state; }
+  int get_index_by_input_symbol(input_symbol e) const {
+    return symbol_index[static_cast<unsigned char>(e)];
+  }
 };
 
 #endif  // DFA_H_
@@ -0,0 +1,118 @@
+//
+// DFACodegen.cpp
+// FiniteAutomataLabExperiments
+//
+
+#include "./DFACodegen.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// Case labels written on one line
+static const int CASES_PER_LINE = 8;
+
+// Constructor.
+DFACodegen::DFACodegen(const DFA &dfa) : compiled(dfa) {
+  compiled.find_live_states(&live);
+  int start = compiled.get_start_state() / compiled.get_n_classes();
+  if (!live[start]) return;
+  // Breadth-first from the start state, emitted doubles as the queue
+  vector<bool> seen(compiled.get_n_states(), false);
+  seen[start] = true;
+  emitted.push_back(start);
+  for (int i = 0; i < emitted.size(); ++i) {
+    for (int e = 0; e < 256; ++e) {
+      int s = next_state(emitted[i], e);
+      if (s >= 0 && !seen[s]) {
+        seen[s] = true;
+        emitted.push_back(s);
+      }
+    }
+  }
+}
+
+// Generate the source of a matcher function.
+string DFACodegen::to_cpp(const string &function_name) const {
+  std::ostringstream out;
+  out << "// Generated by DFACodegen from a DFA having "
+      << compiled.get_n_states() - 1 << " states, do not edit\n\n"
+      << "#include <cstddef>\n\n"
+      << "bool " << function_name << "(const char *str, size_t len) {\n";
+  if (emitted.empty()) {
+    // No string is accepted
+    out << "  (void)str;\n  (void)len;\n  return false;\n}\n";
+    return out.str();
+  }
+  out << "  const unsigned char *p =\n"
+      << "      reinterpret_cast<const unsigned char *>(str);\n"
+      << "  const unsigned char *end = p + len;\n"
+      << "  goto s" << emitted[0] << ";\n";
+  // Blocks of the next states of each byte, -1 for returning false
+  vector<int> next(256);
+  vector<int> counts(compiled.get_n_states() + 1);
+  for (int i = 0; i < emitted.size(); ++i) {
+    int q = emitted[i];
+    out << "s" << q << ":\n  if (p == end) return "
+        << (is_accepting_state(q) ? "true" : "false")
+        << ";\n  switch (*p++) {\n";
+    // The most common next state is the default
+    std::fill(counts.begin(), counts.end(), 0);
+    int most_common = -1;
+    for (int e = 0; e < 256; ++e) {
+      next[e] = next_state(q, e);
+      if (++counts[next[e] + 1] > counts[most_common + 1])
+        most_common = next[e];
+    }
+    // Cases of each other next state, grouped in the order of their first
+    // byte
+    vector<bool> done(256, false);
+    for (int e = 0; e < 256; ++e) {
+      if (done[e] || next[e] == most_common) continue;
+      int on_line = 0;
+      for (int f = e; f < 256; ++f) {
+        if (next[f] != next[e]) continue;
+        if (on_line == 0) out << "   ";
+        out << " case " << case_label(f) << ":";
+        done[f] = true;
+        if (++on_line == CASES_PER_LINE) {
+          out << "\n";
+          on_line = 0;
+        }
+      }
+      if (on_line > 0) out << "\n";
+      if (next[e] < 0)
+        out << "      return false;\n";
+      else
+        out << "      goto s" << next[e] << ";\n";
+    }
+    if (most_common < 0)
+      out << "    default:\n      return false;\n";
+    else
+      out << "    default:\n      goto s" << most_common << ";\n";
+    out << "  }\n";
+  }
+  out << "}\n";
+  return out.str();
+}
+
+// Get the next state of a byte.
+int DFACodegen::next_state(int q, int e) const {
+  int n_classes = compiled.get_n_classes();
+  int s = compiled.tf(q * n_classes, e) / n_classes;
+  return live[s] ? s : -1;
+}
+
+// Write a byte as a case label.
+string DFACodegen::case_label(int e) {
+  if ((e >= 'a' && e <= 'z') || (e >= 'A' && e <= 'Z') ||
+      (e >= '0' && e <= '9'))
+    return string("'") + static_cast<char>(e) + "'";
+  std::ostringstream out;
+  out << e;
+  return out.str();
+}
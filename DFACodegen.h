@@ -0,0 +1,100 @@
+//
+// DFACodegen.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef DFA_CODEGEN_H_
+#define DFA_CODEGEN_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "./CompiledDFA.h"
+#include "./DFA.h"
+
+using std::string;
+using std::vector;
+
+/**
+ Code generator turning a DFA into specialized C++ source.
+
+ The matcher has one labeled block per state and a `switch` on the byte whose
+ cases jump to the blocks of the next states, so transitions are jumps and
+ accept checks are compiled in:
+
+     s1:
+       if (p == end) return false;
+       switch (*p++) {
+         case '0': goto s1;
+         case '1': goto s2;
+         default: return false;
+       }
+
+ Only the states reachable from the start state are emitted. Transitions to
+ states which can no longer reach an accepting state, bytes outside of the
+ alphabet and missing transitions return false right away. Each `switch` has
+ the most common next state of its block as the default.
+ See JitDFA for the same matcher compiled to machine code in process.
+ */
+class DFACodegen {
+ public:
+  /**
+   Constructor.
+   @param dfa DFA to generate code for, changes made to it later are not
+              reflected
+   */
+  explicit DFACodegen(const DFA &dfa);
+
+  /**
+   Generate the source of a matcher function having the signature
+   `bool function_name(const char *str, size_t len)`, returning the same as
+   DFA::evaluate().
+   @param function_name Name of the function
+   @return C++ source, including the headers it needs
+   */
+  string to_cpp(const string &function_name) const;
+
+  /**
+   Get the states emitted, in the order of their blocks.
+   @return States (CompiledDFA state numbers), the start state first
+   */
+  const vector<int> &get_emitted_states() const { return emitted; }
+
+  /**
+   Get the next state of a byte.
+   @param q Current state (state number)
+   @param e Input byte
+   @return Next state (state number), -1 if it is not live
+   */
+  int next_state(int q, int e) const;
+
+  /**
+   Find if the given state is an accepting state.
+   @param q State to check for (state number)
+   @return True if given state is an accepting state, false otherwise
+   */
+  bool is_accepting_state(int q) const {
+    return compiled.is_accepting_state(q * compiled.get_n_classes());
+  }
+
+ private:
+  // Compiled DFA, whose rows are read per byte
+  CompiledDFA compiled;
+
+  // Whether each state can reach an accepting state
+  vector<bool> live;
+
+  // States reachable from the start state which are live, start state first
+  vector<int> emitted;
+
+  /**
+   Write a byte as a case label: a character literal for letters and digits,
+   a number otherwise.
+   @param e Byte
+   @return Case label
+   */
+  static string case_label(int e);
+};
+
+#endif  // DFA_CODEGEN_H_
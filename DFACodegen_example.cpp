@@ -0,0 +1,64 @@
+//
+// DFACodegen_example.cpp
+// FiniteAutomataLabExperiments
+//
+// Print the C++ matcher generated for the DFA matching strings with substring
+// `011`, then match strings with the same DFA compiled to machine code, `-1`
+// to exit. With `quoted` as the first argument only print the matcher of
+// quoted_string_DFA() (see AutomataGenerators.h)
+//
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "AutomataGenerators.h"
+#include "DFA.h"
+#include "DFACodegen.h"
+#include "JitDFA.h"
+
+using std::cin;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && strcmp(argv[1], "quoted") == 0) {
+    cout << DFACodegen(quoted_string_DFA()).to_cpp("match_quoted");
+    return 0;
+  }
+  vector<state> accepting_states;
+  accepting_states.push_back(3);
+  vector<input_symbol> input_symbols;
+  input_symbols.push_back('0');
+  input_symbols.push_back('1');
+  DFA str_011(4, input_symbols, 0, accepting_states);
+  str_011.set_state(0, '0', 1);
+  str_011.set_state(0, '1', 0);
+  str_011.set_state(1, '0', 1);
+  str_011.set_state(1, '1', 2);
+  str_011.set_state(2, '0', 1);
+  str_011.set_state(2, '1', 3);
+  str_011.set_state(3, '0', 3);
+  str_011.set_state(3, '1', 3);
+  cout << DFACodegen(str_011).to_cpp("match_011") << endl;
+
+  JitDFA jit(str_011);
+  if (!jit.is_valid()) {
+    cout << "Machine code is not supported on this platform" << endl;
+    return 1;
+  }
+  cout << "Compiled to " << jit.get_code_size() << " bytes of machine code\n"
+       << endl;
+
+  string str;
+  while (true) {
+    cout << "Enter a string: "; cin >> str;
+    if (str == "-1") break;
+    bool status = jit.evaluate(str);
+    cout << "Status: " << (status ? "Accepted" : "Rejected") << "\n" << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,63 @@
+//
+// DFACodegen_match_011.h
+// FiniteAutomataLabExperiments
+//
+// Matcher of strings with substring `011` generated by DFACodegen, included
+// by DFA_benchmark.cpp only. Regenerate with the first part of the output of
+// DFACodegen_example.cpp:
+//   printf -- '-1\n' | ./DFACodegen_example | sed '/^}$/q'
+//
+
+#ifndef DFA_CODEGEN_MATCH_011_H_
+#define DFA_CODEGEN_MATCH_011_H_
+
+// Generated by DFACodegen from a DFA having 4 states, do not edit
+
+#include <cstddef>
+
+bool match_011(const char *str, size_t len) {
+  const unsigned char *p =
+      reinterpret_cast<const unsigned char *>(str);
+  const unsigned char *end = p + len;
+  goto s0;
+s0:
+  if (p == end) return false;
+  switch (*p++) {
+    case '0':
+      goto s1;
+    case '1':
+      goto s0;
+    default:
+      return false;
+  }
+s1:
+  if (p == end) return false;
+  switch (*p++) {
+    case '0':
+      goto s1;
+    case '1':
+      goto s2;
+    default:
+      return false;
+  }
+s2:
+  if (p == end) return false;
+  switch (*p++) {
+    case '0':
+      goto s1;
+    case '1':
+      goto s3;
+    default:
+      return false;
+  }
+s3:
+  if (p == end) return true;
+  switch (*p++) {
+    case '0': case '1':
+      goto s3;
+    default:
+      return false;
+  }
+}
+
+#endif  // DFA_CODEGEN_MATCH_011_H_
@@ -0,0 +1,68 @@
+//
+// DFACodegen_match_quoted.h
+// FiniteAutomataLabExperiments
+//
+// Matcher of string literals (see quoted_string_DFA() in
+// AutomataGenerators.h) generated by DFACodegen, included by DFA_benchmark.cpp
+// only. Unlike DFACodegen_match_011.h it has groups of cases spanning lines,
+// case labels above 127 and cases returning false. Regenerate with:
+//   ./DFACodegen_example quoted
+//
+
+#ifndef DFA_CODEGEN_MATCH_QUOTED_H_
+#define DFA_CODEGEN_MATCH_QUOTED_H_
+
+// Generated by DFACodegen from a DFA having 4 states, do not edit
+
+#include <cstddef>
+
+bool match_quoted(const char *str, size_t len) {
+  const unsigned char *p =
+      reinterpret_cast<const unsigned char *>(str);
+  const unsigned char *end = p + len;
+  goto s0;
+s0:
+  if (p == end) return false;
+  switch (*p++) {
+    case 34:
+      goto s1;
+    default:
+      return false;
+  }
+s1:
+  if (p == end) return false;
+  switch (*p++) {
+    case 0: case 1: case 2: case 3: case 4: case 5: case 6: case 7:
+    case 8: case 9: case 10: case 11: case 12: case 13: case 14: case 15:
+    case 16: case 17: case 18: case 19: case 20: case 21: case 22: case 23:
+    case 24: case 25: case 26: case 27: case 28: case 29: case 30: case 31:
+    case 127: case 128: case 129: case 130: case 131: case 132: case 133: case 134:
+    case 135: case 136: case 137: case 138: case 139: case 140: case 141: case 142:
+    case 143: case 144: case 145: case 146: case 147: case 148: case 149: case 150:
+    case 151: case 152: case 153: case 154: case 155: case 156: case 157: case 158:
+    case 159:
+      return false;
+    case 34:
+      goto s2;
+    case 92:
+      goto s3;
+    default:
+      goto s1;
+  }
+s2:
+  if (p == end) return true;
+  switch (*p++) {
+    default:
+      return false;
+  }
+s3:
+  if (p == end) return false;
+  switch (*p++) {
+    case 34: case 92: case 'n': case 't':
+      goto s1;
+    default:
+      return false;
+  }
+}
+
+#endif  // DFA_CODEGEN_MATCH_QUOTED_H_
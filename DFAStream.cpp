@@ -0,0 +1,42 @@
+//
+// DFAStream.cpp
+// FiniteAutomataLabExperiments
+//
+
+#include "./DFAStream.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "./MappedFile.h"
+
+// Bytes fed at a time by DFAStream::evaluate_file()
+static const size_t FILE_CHUNK_SIZE = 1 << 20;
+
+// Consume the next chunk of input.
+void DFAStream::feed(const char *str, size_t len) {
+  // Nothing can change once dead
+  if (is_dead()) return;
+  current_state = dfa.run(current_state, str, len);
+}
+
+// End of input.
+bool DFAStream::finish() {
+  bool accepted = dfa.is_accepting_state(current_state);
+  reset();
+  return accepted;
+}
+
+// Evaluate a whole file without reading it into memory.
+bool DFAStream::evaluate_file(const CompiledDFA &dfa, const char *path,
+                              bool *accepted) {
+  MappedFile file(path);
+  if (!file.is_open()) return false;
+  DFAStream stream(dfa);
+  // Feed in chunks so that a dead state stops paging in the rest of the file
+  for (size_t i = 0; i < file.size() && !stream.is_dead();
+       i += FILE_CHUNK_SIZE)
+    stream.feed(file.data() + i, std::min(FILE_CHUNK_SIZE, file.size() - i));
+  *accepted = stream.finish();
+  return true;
+}
@@ -0,0 +1,80 @@
+//
+// DFAStream.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef DFA_STREAM_H_
+#define DFA_STREAM_H_
+
+#include <cstddef>
+
+#include "./CompiledDFA.h"
+
+/**
+ Resumable matcher for a compiled DFA.
+
+ Input can be fed in any number of chunks, the current state is carried over
+ from one chunk to the next. Call finish() after the last chunk to get the
+ result. The compiled DFA is never modified, so one CompiledDFA can be shared
+ by any number of streams.
+ */
+class DFAStream {
+ public:
+  /**
+   Constructor.
+   @param dfa Compiled DFA, must outlive the stream
+   */
+  explicit DFAStream(const CompiledDFA &dfa)
+      : dfa(dfa), current_state(dfa.get_start_state()) {}
+
+  /**
+   Consume the next chunk of input.
+   @param str Bytes to consume
+   @param len Total bytes
+   */
+  void feed(const char *str, size_t len);
+
+  /**
+   End of input, the stream is reset afterwards so that it can be reused.
+   @return True on accepted, false on rejected
+   */
+  bool finish();
+
+  /**
+   Whether the stream reached the dead state, i.e. it will reject regardless
+   of the rest of the input.
+   @return True if dead, false otherwise
+   */
+  bool is_dead() const { return current_state == dfa.get_dead_state(); }
+
+  /**
+   Get current state.
+   @return Current state (row offset)
+   */
+  state get_current_state() const { return current_state; }
+
+  /**
+   Reset current state, i.e. set current state to start state.
+   */
+  void reset() { current_state = dfa.get_start_state(); }
+
+  /**
+   Evaluate a whole file without reading it into memory, the file is
+   memory-mapped and fed to a stream.
+   @param dfa Compiled DFA
+   @param path Path to the file
+   @param accepted Set to true on accepted, false on rejected
+   @return True on success, false if the file could not be mapped
+   */
+  static bool evaluate_file(const CompiledDFA &dfa, const char *path,
+                            bool *accepted);
+
+ private:
+  // Compiled DFA
+  const CompiledDFA &dfa;
+
+  // Current state (row offset)
+  state current_state;
+};
+
+#endif  // DFA_STREAM_H_
@@ -0,0 +1,54 @@
+//
+// DFAStream_example.cpp
+// FiniteAutomataLabExperiments
+//
+// Match a file (or the standard input read in chunks) having substring `011`
+//
+
+#include <iostream>
+#include <vector>
+
+#include "CompiledDFA.h"
+#include "DFA.h"
+#include "DFAStream.h"
+
+using std::cin;
+using std::cout;
+using std::endl;
+using std::vector;
+
+int main(int argc, char *argv[]) {
+  vector<state> accepting_states;
+  accepting_states.push_back(3);
+  vector<input_symbol> input_symbols;
+  input_symbols.push_back('0');
+  input_symbols.push_back('1');
+  DFA str_011(4, input_symbols, 0, accepting_states);
+  str_011.set_state(0, '0', 1);
+  str_011.set_state(0, '1', 0);
+  str_011.set_state(1, '0', 1);
+  str_011.set_state(1, '1', 2);
+  str_011.set_state(2, '0', 1);
+  str_011.set_state(2, '1', 3);
+  str_011.set_state(3, '0', 3);
+  str_011.set_state(3, '1', 3);
+  CompiledDFA compiled(str_011);
+
+  bool status;
+  if (argc > 1) {
+    if (!DFAStream::evaluate_file(compiled, argv[1], &status)) {
+      cout << "Cannot open " << argv[1] << endl;
+      return 1;
+    }
+  } else {
+    // Input may contain newlines, which are rejected like any other symbol
+    // outside of the alphabet
+    DFAStream stream(compiled);
+    char buffer[4096];
+    while (cin.read(buffer, sizeof(buffer)) || cin.gcount() > 0)
+      stream.feed(buffer, cin.gcount());
+    status = stream.finish();
+  }
+  cout << "Status: " << (status ? "Accepted" : "Rejected") << endl;
+  return 0;
+}
@@ -0,0 +1,485 @@
+//
+// DFA_benchmark.cpp
+// FiniteAutomataLabExperiments
+//
+// Throughput of DFA::evaluate() against the compiled DFA, its batch and
+// parallel APIs, of DFAs before and after minimization, memory against
+// throughput of the compressed transition table, of a DFA compiled to C++ and
+// to machine code, of batches spread over a thread pool and of boolean
+// combinations of DFAs. Builds with C++11, the DFA built at compile time is
+// measured by StaticDFA_benchmark.cpp
+//
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AutomataGenerators.h"
+#include "CompiledDFA.h"
+#include "CompressedDFA.h"
+#include "DFA.h"
+#include "DFACodegen.h"
+#include "DFACodegen_match_011.h"
+#include "DFACodegen_match_quoted.h"
+#include "JitDFA.h"
+#include "MultiDFA.h"
+#include "ProductDFA.h"
+#include "ThreadPool.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+// Input size in bytes
+static const size_t INPUT_SIZE = 16 << 20;
+
+// Total records for the batch benchmark
+static const size_t N_RECORDS = 1 << 20;
+
+// Seconds elapsed since the given time point
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+// Output throughput of a run
+static void report(const char *name, double seconds, bool status) {
+  cout << name << ": " << (INPUT_SIZE / seconds / (1 << 20)) << " MB/s ("
+       << (status ? "Accepted" : "Rejected") << ")" << endl;
+}
+
+// Benchmark both paths of a DFA
+static void benchmark(const char *name, DFA *dfa, const string &str) {
+  cout << name << endl;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  bool status = dfa->evaluate(str);
+  report("  DFA::evaluate        ", seconds_since(start), status);
+
+  CompiledDFA compiled(*dfa);
+  start = std::chrono::steady_clock::now();
+  status = compiled.evaluate(str);
+  report("  CompiledDFA::evaluate", seconds_since(start), status);
+}
+
+// Output throughput of a batch run
+static void report_batch(const string &name, double seconds,
+                         const vector<uint64_t> &accepted,
+                         const vector<uint64_t> &expected) {
+  cout << name << ": " << (N_RECORDS / seconds / 1e6) << " M records/s"
+       << (accepted == expected ? "" : " (MISMATCH)") << endl;
+}
+
+// Benchmark the batch API against one DFA::evaluate() call per record
+static void benchmark_batch(const char *name, DFA *dfa,
+                            const vector<string> &records) {
+  cout << name << endl;
+  vector<uint64_t> expected((records.size() + 63) / 64, 0);
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (size_t i = 0; i < records.size(); ++i)
+    if (dfa->evaluate(records[i]))
+      expected[i >> 6] |= static_cast<uint64_t>(1) << (i & 63);
+  report_batch("  DFA::evaluate         ", seconds_since(start), expected,
+               expected);
+
+  CompiledDFA compiled(*dfa);
+  vector<uint64_t> accepted((records.size() + 63) / 64, 0);
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < records.size(); ++i)
+    if (compiled.evaluate(records[i]))
+      accepted[i >> 6] |= static_cast<uint64_t>(1) << (i & 63);
+  report_batch("  CompiledDFA::evaluate ", seconds_since(start), accepted,
+               expected);
+
+  for (int width = 1; width <= 16; width *= 2) {
+    start = std::chrono::steady_clock::now();
+    compiled.evaluate_batch(records, &accepted, width);
+    report_batch("  evaluate_batch width " + std::to_string(width) +
+                 (width < 10 ? " " : ""), seconds_since(start), accepted,
+                 expected);
+  }
+#ifdef __AVX2__
+  start = std::chrono::steady_clock::now();
+  compiled.evaluate_batch(records, &accepted, 8, true);
+  report_batch("  evaluate_batch AVX2   ", seconds_since(start), accepted,
+               expected);
+#endif
+}
+
+// Benchmark batches spread over thread pools of increasing size, the compiled
+// DFA and the DFA being shared by all the threads
+static void benchmark_pool(const char *name, const DFA &dfa,
+                           const vector<string> &records) {
+  cout << name << endl;
+  CompiledDFA compiled(dfa);
+  vector<uint64_t> expected, accepted;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  compiled.evaluate_batch(records, &expected);
+  report_batch("  evaluate_batch          ", seconds_since(start),
+               expected, expected);
+  int n_cores = std::max<int>(1, std::thread::hardware_concurrency());
+  for (int n_threads = 1; ; n_threads = std::min(2 * n_threads, n_cores)) {
+    ThreadPool pool(n_threads);
+    string threads = std::to_string(n_threads) + " thread(s)";
+    start = std::chrono::steady_clock::now();
+    compiled.evaluate_batch(records, &accepted, &pool);
+    report_batch("  CompiledDFA, " + threads, seconds_since(start), accepted,
+                 expected);
+
+    accepted.assign(expected.size(), 0);
+    start = std::chrono::steady_clock::now();
+    pool.parallel_for(records.size(), 1024, [&](size_t first, size_t last) {
+      for (size_t i = first; i < last; ++i)
+        if (dfa.evaluate(records[i]))
+          accepted[i >> 6] |= static_cast<uint64_t>(1) << (i & 63);
+    });
+    report_batch("  DFA,         " + threads, seconds_since(start), accepted,
+                 expected);
+    if (n_threads == n_cores) break;
+  }
+}
+
+// Benchmark one MultiDFA::match() call per record against one
+// CompiledDFA::evaluate() call per record and pattern
+static void benchmark_multi(const char *name, const vector<DFA> &patterns,
+                            const vector<string> &records) {
+  cout << name << endl;
+  vector<CompiledDFA> compiled;
+  for (int i = 0; i < patterns.size(); ++i)
+    compiled.push_back(CompiledDFA(patterns[i]));
+  size_t expected = 0;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (size_t i = 0; i < records.size(); ++i)
+    for (int j = 0; j < compiled.size(); ++j)
+      expected += compiled[j].evaluate(records[i]);
+  cout << "  CompiledDFA::evaluate per pattern: "
+       << (records.size() / seconds_since(start) / 1e6) << " M records/s"
+       << endl;
+
+  MultiDFA multi(compiled);
+  vector<int> matched;
+  size_t total = 0;
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < records.size(); ++i) {
+    multi.match(records[i], &matched);
+    total += matched.size();
+  }
+  cout << "  MultiDFA::match:                  "
+       << (records.size() / seconds_since(start) / 1e6) << " M records/s, "
+       << multi.get_cache_stats().states << " product states"
+       << (total == expected ? "" : " (MISMATCH)") << endl;
+}
+
+// Benchmark parallel evaluation of one large string for 1 to 8 threads,
+// starting the threads for the call and using the threads of a pool
+static void benchmark_parallel(const char *name, DFA *dfa, const string &str) {
+  cout << name << endl;
+  CompiledDFA compiled(*dfa);
+  bool expected = compiled.evaluate(str);
+  for (int n_threads = 1; n_threads <= 8; n_threads *= 2) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    bool status = compiled.evaluate_parallel(str, n_threads);
+    cout << "  " << n_threads << " thread(s):       "
+         << (INPUT_SIZE / seconds_since(start) / (1 << 20)) << " MB/s"
+         << (status == expected ? "" : " (MISMATCH)") << endl;
+
+    ThreadPool pool(n_threads);
+    start = std::chrono::steady_clock::now();
+    status = compiled.evaluate_parallel(str, &pool);
+    cout << "  " << n_threads << " thread(s), pool: "
+         << (INPUT_SIZE / seconds_since(start) / (1 << 20)) << " MB/s"
+         << (status == expected ? "" : " (MISMATCH)") << endl;
+  }
+}
+
+// Report states and throughput of a DFA before and after minimization
+static void benchmark_minimize(const char *name, const DFA &dfa,
+                               const string &str) {
+  cout << name << endl;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  DFA minimal = dfa.minimize();
+  cout << "  DFA::minimize: " << seconds_since(start) * 1e3 << " ms" << endl;
+
+  CompiledDFA before(dfa), after(minimal);
+  start = std::chrono::steady_clock::now();
+  bool status = before.evaluate(str);
+  double seconds = seconds_since(start);
+  cout << "  Before: " << dfa.get_n_states() << " states, "
+       << (INPUT_SIZE / seconds / (1 << 20)) << " MB/s" << endl;
+  start = std::chrono::steady_clock::now();
+  bool min_status = after.evaluate(str);
+  seconds = seconds_since(start);
+  cout << "  After:  " << minimal.get_n_states() << " states, "
+       << (INPUT_SIZE / seconds / (1 << 20)) << " MB/s"
+       << (status == min_status ? "" : " (MISMATCH)") << endl;
+}
+
+// Report memory and throughput of the dense and compressed layouts, and the
+// layout picked automatically
+static void benchmark_compressed(const char *name, const DFA &dfa,
+                                 const string &str) {
+  cout << name << endl;
+  const CompressedDFA::Layout layouts[] = {
+    CompressedDFA::LAYOUT_DENSE, CompressedDFA::LAYOUT_COMPRESSED
+  };
+  const char *names[] = { "  Dense:     ", "  Compressed:" };
+  bool expected = CompiledDFA(dfa).evaluate(str);
+  for (int i = 0; i < 2; ++i) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    CompressedDFA compressed(dfa, layouts[i]);
+    double build = seconds_since(start);
+    start = std::chrono::steady_clock::now();
+    bool status = compressed.evaluate(str);
+    double seconds = seconds_since(start);
+    cout << names[i] << " " << compressed.get_memory_usage() / 1024.0
+         << " KB, " << (INPUT_SIZE / seconds / (1 << 20)) << " MB/s, built in "
+         << build * 1e3 << " ms" << (status == expected ? "" : " (MISMATCH)")
+         << endl;
+  }
+  CompressedDFA automatic(dfa);
+  if (automatic.get_layout() == CompressedDFA::LAYOUT_DENSE) {
+    cout << "  Automatic:   dense" << endl;
+  } else {
+    cout << "  Automatic:   compressed, " << automatic.get_n_rows()
+         << " distinct rows" << endl;
+  }
+}
+
+// Benchmark the DFA compiled to C++ (checked-in output of DFACodegen, if
+// any) and to machine code against the table-driven ones, and check that both
+// answer the same as DFA::evaluate() on the input and on every record
+static void benchmark_codegen(const char *name, DFA *dfa, const string &str,
+                              const vector<string> &records,
+                              bool (*generated)(const char *, size_t) = NULL) {
+  benchmark(name, dfa, str);
+  if (generated != NULL) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    bool status = generated(str.data(), str.size());
+    report("  Generated C++        ", seconds_since(start), status);
+    size_t mismatches = status != dfa->evaluate(str);
+    for (size_t i = 0; i < records.size(); ++i)
+      mismatches += generated(records[i].data(), records[i].size()) !=
+                    dfa->evaluate(records[i]);
+    cout << "  Generated C++: " << mismatches << " mismatches in "
+         << records.size() << " records"
+         << (mismatches == 0 ? "" : " (MISMATCH)") << endl;
+  }
+  JitDFA jit(*dfa);
+  if (!jit.is_valid()) {
+    cout << "  JitDFA: not supported" << endl;
+    return;
+  }
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  bool status = jit.evaluate(str);
+  report("  JitDFA::evaluate     ", seconds_since(start), status);
+
+  size_t mismatches = 0;
+  for (size_t i = 0; i < records.size(); ++i)
+    mismatches += jit.evaluate(records[i]) != dfa->evaluate(records[i]);
+  cout << "  " << DFACodegen(*dfa).get_emitted_states().size()
+       << " states emitted, " << jit.get_code_size() / 1024.0
+       << " KB of machine code, " << mismatches << " mismatches in "
+       << records.size() << " records" << (mismatches == 0 ? "" : " (MISMATCH)")
+       << endl;
+}
+
+// Full product DFA accepting the strings of a but not of b, built by hand
+// over every pair of states
+static DFA full_difference_DFA(const DFA &a, const DFA &b) {
+  const vector<input_symbol> &input_symbols = a.get_input_symbols();
+  int n_b = b.get_n_states();
+  vector<state> accepting_states;
+  for (int qa = 0; qa < a.get_n_states(); ++qa)
+    for (int qb = 0; qb < n_b; ++qb)
+      if (a.is_accepting_state(qa) && !b.is_accepting_state(qb))
+        accepting_states.push_back(qa * n_b + qb);
+  DFA dfa(a.get_n_states() * n_b, input_symbols,
+          a.get_start_state() * n_b + b.get_start_state(), accepting_states);
+  for (int qa = 0; qa < a.get_n_states(); ++qa)
+    for (int qb = 0; qb < n_b; ++qb)
+      for (int j = 0; j < input_symbols.size(); ++j)
+        dfa.set_state(qa * n_b + qb, input_symbols[j],
+                      a.tf(qa, input_symbols[j]) * n_b +
+                      b.tf(qb, input_symbols[j]));
+  return dfa;
+}
+
+// Benchmark the difference of two DFAs having the same input symbols, built
+// in full against built on demand
+static void benchmark_product(const char *name, const DFA &a, const DFA &b,
+                              const vector<string> &records) {
+  cout << name << endl;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  DFA full = full_difference_DFA(a, b);
+  cout << "  Full product:    " << full.get_n_states() << " states, built in "
+       << seconds_since(start) * 1e3 << " ms" << endl;
+  size_t expected = 0;
+  CompiledDFA compiled(full);
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < records.size(); ++i)
+    expected += compiled.evaluate(records[i]);
+  cout << "    CompiledDFA::evaluate " << (records.size() /
+       seconds_since(start) / 1e6) << " M records/s" << endl;
+
+  ProductDFA lazy(a, b, ProductDFA::OPERATION_DIFFERENCE);
+  size_t total = 0;
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < records.size(); ++i)
+    total += lazy.evaluate(records[i]);
+  cout << "  On demand:       " << lazy.get_n_states() << " states, "
+       << (records.size() / seconds_since(start) / 1e6) << " M records/s"
+       << (total == expected ? "" : " (MISMATCH)") << endl;
+
+  ProductDFA product(a, b, ProductDFA::OPERATION_DIFFERENCE);
+  start = std::chrono::steady_clock::now();
+  DFA reachable = product.to_DFA();
+  double build = seconds_since(start);
+  start = std::chrono::steady_clock::now();
+  DFA minimal = reachable.minimize();
+  cout << "  Breadth-first:   " << reachable.get_n_states()
+       << " states, built in " << build * 1e3 << " ms, " << "minimized to "
+       << minimal.get_n_states() << " in " << seconds_since(start) * 1e3
+       << " ms" << endl;
+  total = 0;
+  CompiledDFA compiled_minimal(minimal);
+  for (size_t i = 0; i < records.size(); ++i)
+    total += compiled_minimal.evaluate(records[i]);
+  if (total != expected) cout << "  (MISMATCH)" << endl;
+}
+
+// Substring `011` DFA carrying a counter modulo n_counter which never affects
+// acceptance, i.e. 4 * n_counter states minimizing to 4
+static DFA redundant_011_DFA(int n_counter) {
+  static const state next[4][2] = { {1, 0}, {1, 2}, {1, 3}, {3, 3} };
+  vector<input_symbol> binary;
+  binary.push_back('0');
+  binary.push_back('1');
+  vector<state> accepting_states;
+  for (int c = 0; c < n_counter; ++c)
+    accepting_states.push_back(3 * n_counter + c);
+  DFA dfa(4 * n_counter, binary, 0, accepting_states);
+  for (int q = 0; q < 4; ++q)
+    for (int c = 0; c < n_counter; ++c)
+      for (int j = 0; j < 2; ++j)
+        dfa.set_state(q * n_counter + c, binary[j],
+                      next[q][j] * n_counter + (c + 1) % n_counter);
+  return dfa;
+}
+
+// Random records of 8 to 64 symbols
+static vector<string> random_records(const vector<input_symbol> &input_symbols,
+                                     std::mt19937 *rng) {
+  vector<string> records(N_RECORDS);
+  for (size_t i = 0; i < N_RECORDS; ++i)
+    records[i] = random_string(input_symbols, 8 + (*rng)() % 57, rng);
+  return records;
+}
+
+// Random string literals of 8 to 64 bytes, one in four having a random byte
+// put somewhere
+static vector<string> random_quoted_records(std::mt19937 *rng) {
+  vector<string> records(N_RECORDS);
+  for (size_t i = 0; i < N_RECORDS; ++i) {
+    records[i] = random_quoted_string(8 + (*rng)() % 57, rng);
+    if ((*rng)() % 4 == 0)
+      records[i][(*rng)() % records[i].size()] =
+          static_cast<char>(1 + (*rng)() % 255);
+  }
+  return records;
+}
+
+int main() {
+  std::mt19937 rng(2018);
+  vector<input_symbol> binary;
+  binary.push_back('0');
+  binary.push_back('1');
+  vector<input_symbol> letters;
+  for (char c = 'a'; c <= 'z'; ++c) letters.push_back(c);
+
+  // Strings with substring `011`, see DFA_example.cpp
+  vector<state> accepting_states;
+  accepting_states.push_back(3);
+  DFA str_011(4, binary, 0, accepting_states);
+  str_011.set_state(0, '0', 1);
+  str_011.set_state(0, '1', 0);
+  str_011.set_state(1, '0', 1);
+  str_011.set_state(1, '1', 2);
+  str_011.set_state(2, '0', 1);
+  str_011.set_state(2, '1', 3);
+  str_011.set_state(3, '0', 3);
+  str_011.set_state(3, '1', 3);
+  benchmark("Substring 011 (4 states, 2 symbols)", &str_011,
+            random_string(binary, INPUT_SIZE, &rng));
+
+  DFA random = random_DFA(1024, letters, &rng);
+  benchmark("Random (1024 states, 26 symbols)", &random,
+            random_string(letters, INPUT_SIZE, &rng));
+
+  benchmark_parallel("Parallel: substring 011", &str_011,
+                     random_string(binary, INPUT_SIZE, &rng));
+  benchmark_parallel("Parallel: random (1024 states, 26 symbols)", &random,
+                     random_string(letters, INPUT_SIZE, &rng));
+
+  benchmark_minimize("Minimize: substring 011 with a counter",
+                     redundant_011_DFA(1 << 16),
+                     random_string(binary, INPUT_SIZE, &rng));
+  benchmark_minimize("Minimize: random (1024 states, 26 symbols)", random,
+                     random_string(letters, INPUT_SIZE, &rng));
+
+  benchmark_batch("Batch: substring 011", &str_011,
+                  random_records(binary, &rng));
+  DFA large = random_DFA(1 << 16, letters, &rng);
+  benchmark_batch("Batch: random (65536 states, 26 symbols)", &large,
+                  random_records(letters, &rng));
+
+  benchmark_pool("Pool: random (65536 states, 26 symbols)", large,
+                 random_records(letters, &rng));
+
+  DFA long_word = substring_DFA(random_string(letters, 1 << 16, &rng),
+                                letters);
+  benchmark_compressed("Compressed: substring of 65536 letters", long_word,
+                       random_string(letters, INPUT_SIZE, &rng));
+  benchmark_compressed("Compressed: random (65536 states, 26 symbols)", large,
+                       random_string(letters, INPUT_SIZE, &rng));
+
+  benchmark_codegen("Codegen: substring 011", &str_011,
+                    random_string(binary, INPUT_SIZE, &rng),
+                    random_records(binary, &rng), match_011);
+  DFA word = substring_DFA(random_string(letters, 16, &rng), letters);
+  benchmark_codegen("Codegen: substring of 16 letters", &word,
+                    random_string(letters, INPUT_SIZE, &rng),
+                    random_records(letters, &rng));
+  benchmark_codegen("Codegen: random (1024 states, 26 symbols)", &random,
+                    random_string(letters, INPUT_SIZE, &rng),
+                    random_records(letters, &rng));
+  DFA quoted = quoted_string_DFA();
+  benchmark_codegen("Codegen: string literal (255 symbols)", &quoted,
+                    random_quoted_string(INPUT_SIZE, &rng),
+                    random_quoted_records(&rng), match_quoted);
+
+  DFA word_a = substring_DFA(random_string(letters, 512, &rng), letters);
+  DFA word_b = substring_DFA(random_string(letters, 512, &rng), letters);
+  benchmark_product("Product: substring of 512 letters but not another",
+                    word_a, word_b, random_records(letters, &rng));
+
+  vector<DFA> words;
+  for (int i = 0; i < 32; ++i)
+    words.push_back(substring_DFA(random_string(letters, 3, &rng), letters));
+  benchmark_multi("Multi-pattern: 32 substrings of 3 letters", words,
+                  random_records(letters, &rng));
+  return 0;
+}
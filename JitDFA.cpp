@@ -0,0 +1,212 @@
+//
+// JitDFA.cpp
+// FiniteAutomataLabExperiments
+//
+
+#include "./JitDFA.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "./DFACodegen.h"
+
+using std::vector;
+
+#if defined(__x86_64__) && defined(__linux__)
+
+// Most exceptions to the default next state dispatched by compares, more
+// use a jump table
+static const int MAX_COMPARES = 8;
+
+// A 32-bit offset to patch once every label is placed.
+struct Fixup {
+  // Position of the offset in the code
+  int pos;
+  // Label the offset points to
+  int label;
+  // Position the offset is relative to
+  int base;
+};
+
+// Append bytes to the code.
+static void emit(vector<unsigned char> *code, const char *bytes, int n) {
+  code->insert(code->end(), bytes, bytes + n);
+}
+
+// Append a 32-bit little-endian value to the code.
+static void emit32(vector<unsigned char> *code, uint32_t value) {
+  for (int i = 0; i < 4; ++i) code->push_back((value >> (8 * i)) & 0xFF);
+}
+
+// Append a jump offset relative to the end of the instruction.
+static void emit_rel32(vector<unsigned char> *code, vector<Fixup> *fixups,
+                       int label) {
+  Fixup fixup = {static_cast<int>(code->size()), label,
+                 static_cast<int>(code->size()) + 4};
+  fixups->push_back(fixup);
+  emit32(code, 0);
+}
+
+// Constructor.
+JitDFA::JitDFA(const DFA &dfa) : matcher(NULL), code(NULL), code_size(0) {
+  DFACodegen codegen(dfa);
+  const vector<int> &emitted = codegen.get_emitted_states();
+  if (emitted.size() > MAX_STATES) return;
+  // Labels: a block per emitted state, then the exits, then the jump tables
+  vector<int> label_of_state;
+  vector<int> labels(emitted.size() + 2, -1);
+  const int ACCEPT = emitted.size(), REJECT = ACCEPT + 1;
+  for (int i = 0; i < emitted.size(); ++i) {
+    if (emitted[i] >= label_of_state.size())
+      label_of_state.resize(emitted[i] + 1, REJECT);
+    label_of_state[emitted[i]] = i;
+  }
+  vector<unsigned char> bytes;
+  vector<Fixup> fixups;
+  // Jump tables to append after the code: label and targets of each
+  vector< std::pair<int, vector<int> > > tables;
+  vector<int> targets(256);
+  vector<int> counts(labels.size());
+  for (int i = 0; i < emitted.size(); ++i) {
+    int q = emitted[i];
+    labels[i] = bytes.size();
+    // cmp rdi, rsi; jae ACCEPT or REJECT
+    emit(&bytes, "\x48\x39\xF7\x0F\x83", 5);
+    emit_rel32(&bytes, &fixups,
+               codegen.is_accepting_state(q) ? ACCEPT : REJECT);
+    // movzx eax, byte [rdi]; inc rdi
+    emit(&bytes, "\x0F\xB6\x07\x48\xFF\xC7", 6);
+    // Bytes below lo and above hi are rejected, within them the most common
+    // next state is the default and the other runs of bytes are exceptions
+    int lo = 0, hi = 255;
+    for (int e = 0; e < 256; ++e) {
+      int s = codegen.next_state(q, e);
+      targets[e] = s < 0 ? REJECT : label_of_state[s];
+    }
+    while (lo < 256 && targets[lo] == REJECT) ++lo;
+    while (hi >= lo && targets[hi] == REJECT) --hi;
+    if (lo > hi) {
+      // jmp REJECT
+      bytes.push_back(0xE9);
+      emit_rel32(&bytes, &fixups, REJECT);
+      continue;
+    }
+    std::fill(counts.begin(), counts.end(), 0);
+    int most_common = targets[lo];
+    for (int e = lo; e <= hi; ++e)
+      if (++counts[targets[e]] > counts[most_common]) most_common = targets[e];
+    int n_exceptions = 0;
+    for (int e = lo; e <= hi; ++e)
+      if (targets[e] != most_common &&
+          (e == lo || targets[e] != targets[e - 1]))
+        ++n_exceptions;
+    if (n_exceptions <= MAX_COMPARES) {
+      // cmp eax, lo; jb REJECT; cmp eax, hi; ja REJECT
+      if (lo > 0) {
+        bytes.push_back(0x3D);
+        emit32(&bytes, lo);
+        emit(&bytes, "\x0F\x82", 2);
+        emit_rel32(&bytes, &fixups, REJECT);
+      }
+      if (hi < 255) {
+        bytes.push_back(0x3D);
+        emit32(&bytes, hi);
+        emit(&bytes, "\x0F\x87", 2);
+        emit_rel32(&bytes, &fixups, REJECT);
+      }
+      for (int e = lo; e <= hi; ++e) {
+        if (targets[e] == most_common) continue;
+        int last = e;
+        while (last < hi && targets[last + 1] == targets[e]) ++last;
+        if (last == e) {
+          // cmp eax, e; je target
+          bytes.push_back(0x3D);
+          emit32(&bytes, e);
+          emit(&bytes, "\x0F\x84", 2);
+        } else {
+          // lea ecx, [rax - e]; cmp ecx, last - e; jbe target
+          emit(&bytes, "\x8D\x88", 2);
+          emit32(&bytes, -e);
+          emit(&bytes, "\x81\xF9", 2);
+          emit32(&bytes, last - e);
+          emit(&bytes, "\x0F\x86", 2);
+        }
+        emit_rel32(&bytes, &fixups, targets[e]);
+        e = last;
+      }
+      // jmp most common target
+      bytes.push_back(0xE9);
+      emit_rel32(&bytes, &fixups, most_common);
+    } else {
+      // lea rcx, [rip + table]; movsxd rdx, dword [rcx + rax * 4];
+      // add rdx, rcx; jmp rdx
+      int table = labels.size();
+      labels.push_back(-1);
+      emit(&bytes, "\x48\x8D\x0D", 3);
+      emit_rel32(&bytes, &fixups, table);
+      emit(&bytes, "\x48\x63\x14\x81\x48\x01\xCA\xFF\xE2", 9);
+      tables.push_back(std::make_pair(table, targets));
+    }
+  }
+  // ACCEPT: mov eax, 1; ret
+  labels[ACCEPT] = bytes.size();
+  emit(&bytes, "\xB8\x01\x00\x00\x00\xC3", 6);
+  // REJECT: xor eax, eax; ret
+  labels[REJECT] = bytes.size();
+  emit(&bytes, "\x31\xC0\xC3", 3);
+  // Jump tables, entries are relative to the start of their table
+  for (int i = 0; i < tables.size(); ++i) {
+    while (bytes.size() % 4 != 0) bytes.push_back(0xCC);
+    int base = bytes.size();
+    labels[tables[i].first] = base;
+    for (int e = 0; e < 256; ++e) {
+      Fixup fixup = {static_cast<int>(bytes.size()), tables[i].second[e],
+                     base};
+      fixups.push_back(fixup);
+      emit32(&bytes, 0);
+    }
+  }
+  for (int i = 0; i < fixups.size(); ++i) {
+    uint32_t offset = labels[fixups[i].label] - fixups[i].base;
+    std::memcpy(&bytes[fixups[i].pos], &offset, 4);
+  }
+  // Write then make executable, never both at once
+  void *addr = mmap(NULL, bytes.size(), PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) return;
+  std::memcpy(addr, bytes.data(), bytes.size());
+  if (mprotect(addr, bytes.size(), PROT_READ | PROT_EXEC) != 0) {
+    munmap(addr, bytes.size());
+    return;
+  }
+  code = addr;
+  code_size = bytes.size();
+  int entry = emitted.empty() ? labels[REJECT] : labels[0];
+  matcher = reinterpret_cast<Matcher>(static_cast<char *>(addr) + entry);
+}
+
+// Destructor.
+JitDFA::~JitDFA() {
+  if (code != NULL) munmap(code, code_size);
+}
+
+#else
+
+// Constructor, nothing is compiled on other platforms.
+JitDFA::JitDFA(const DFA &dfa) : matcher(NULL), code(NULL), code_size(0) {
+  (void)dfa;
+}
+
+// Destructor.
+JitDFA::~JitDFA() {}
+
+#endif
@@ -0,0 +1,106 @@
+//
+// JitDFA.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef JIT_DFA_H_
+#define JIT_DFA_H_
+
+#include <cstddef>
+#include <string>
+
+#include "./DFA.h"
+
+using std::string;
+
+/**
+ DFA compiled to x86-64 machine code in process.
+
+ The code has the layout of the source of DFACodegen: one block per state
+ reachable from the start state which checks for the end of the input, loads
+ a byte and jumps to the block of the next state. A block first rejects the
+ bytes below and above those having a transition, then compares the byte
+ against the few runs of bytes not going to its most common next state and
+ jumps to that state otherwise. A block having more such runs dispatches
+ through its own table of 256 jump offsets. Transitions to states which can
+ no longer reach an accepting state jump straight to a shared reject exit.
+
+ Each byte costs a branch, so the matcher beats CompiledDFA only when the
+ branches are predictable, i.e. when most bytes take the default of their
+ block: e.g. substring DFAs, where it is 1.5 to 3 times as fast. Otherwise
+ CompiledDFA should be used instead: the matcher is about 1.5 times slower on
+ string literals having an escape every 8 bytes or so, and about 4 times
+ slower on a random DFA over 26 letters fed random letters, where the jump
+ tables mispredict.
+
+ Only x86-64 Linux is supported, elsewhere and when mapping executable memory
+ fails is_valid() is false.
+ */
+class JitDFA {
+ public:
+  // Most states compiled, larger DFAs are not valid
+  static const int MAX_STATES = 1 << 16;
+
+  /**
+   Constructor.
+   @param dfa DFA to compile, changes made to it later are not reflected
+   */
+  explicit JitDFA(const DFA &dfa);
+
+  /**
+   Destructor.
+   */
+  ~JitDFA();
+
+  /**
+   Whether the DFA is compiled.
+   @return True if compiled, false otherwise
+   */
+  bool is_valid() const { return matcher != NULL; }
+
+  /**
+   Evaluate the given string.
+   @param str String to evaluate
+   @return True on accepted, false on rejected or if not valid
+   */
+  bool evaluate(const string &str) const {
+    return evaluate(str.data(), str.size());
+  }
+
+  /**
+   Evaluate the given bytes.
+   @param str Bytes to evaluate
+   @param len Total bytes
+   @return True on accepted, false on rejected or if not valid
+   */
+  bool evaluate(const char *str, size_t len) const {
+    if (matcher == NULL) return false;
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(str);
+    return matcher(p, p + len) != 0;
+  }
+
+  /**
+   Get size of the machine code, jump tables included.
+   @return Total bytes, 0 if not valid
+   */
+  size_t get_code_size() const { return code_size; }
+
+ private:
+  // Signature of the compiled code, returns 1 on accepted and 0 on rejected
+  typedef int (*Matcher)(const unsigned char *p, const unsigned char *end);
+
+  // Entry point, NULL if not valid
+  Matcher matcher;
+
+  // Executable mapping holding the code
+  void *code;
+
+  // Total bytes of the code
+  size_t code_size;
+
+  // Not copyable
+  JitDFA(const JitDFA &);
+  JitDFA &operator=(const JitDFA &);
+};
+
+#endif  // JIT_DFA_H_
@@ -0,0 +1,44 @@
+//
+// MappedFile.cpp
+// FiniteAutomataLabExperiments
+//
+
+#include "./MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+
+// Constructor.
+MappedFile::MappedFile(const char *path, Access access)
+    : bytes(NULL), length(0), opened(false) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return;
+  struct stat st;
+  if (fstat(fd, &st) == 0) {
+    length = st.st_size;
+    if (length == 0) {
+      opened = true;
+    } else {
+      void *addr = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        // Readahead helps front to back reads but wastes I/O and evicts
+        // pages which are still needed when the reads jump around
+        madvise(addr, length,
+                access == SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+        bytes = static_cast<const char *>(addr);
+        opened = true;
+      }
+    }
+  }
+  // The mapping stays valid after closing the descriptor
+  close(fd);
+}
+
+// Destructor.
+MappedFile::~MappedFile() {
+  if (bytes != NULL) munmap(const_cast<char *>(bytes), length);
+}
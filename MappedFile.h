@@ -0,0 +1,72 @@
+//
+// MappedFile.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+
+/**
+ Read-only memory mapped file.
+
+ The whole file is mapped on construction and unmapped on destruction, use
+ is_open() to check whether mapping was successful.
+ */
+class MappedFile {
+ public:
+  /**
+   How the mapped bytes are going to be read, passed on to the kernel.
+   */
+  enum Access {
+    SEQUENTIAL,  // Front to back once, e.g. input of a matcher
+    RANDOM       // Anywhere and repeatedly, e.g. a transition table
+  };
+
+  /**
+   Constructor.
+   @param path Path to the file to map
+   @param access How the file is going to be read
+   */
+  explicit MappedFile(const char *path, Access access = SEQUENTIAL);
+
+  /**
+   Destructor.
+   */
+  ~MappedFile();
+
+  /**
+   Whether the file is mapped.
+   @return True if mapped, false otherwise
+   */
+  bool is_open() const { return opened; }
+
+  /**
+   Get contents of the file.
+   @return Pointer to the first byte, NULL for empty or unmapped files
+   */
+  const char *data() const { return bytes; }
+
+  /**
+   Get size of the file.
+   @return Total bytes
+   */
+  size_t size() const { return length; }
+
+ private:
+  // Mapped bytes
+  const char *bytes;
+
+  // Total bytes
+  size_t length;
+
+  // Whether the file is mapped
+  bool opened;
+
+  // Not copyable
+  MappedFile(const MappedFile &);
+  MappedFile &operator=(const MappedFile &);
+};
+
+#endif  // MAPPED_FILE_H_
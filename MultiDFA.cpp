@@ -0,0 +1,133 @@
+//
+// MultiDFA.cpp
+// FiniteAutomataLabExperiments
+//
+
+#include "./MultiDFA.h"
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// Init DEFAULT_CACHE_BUDGET
+const size_t MultiDFA::DEFAULT_CACHE_BUDGET;
+
+// Init CACHE_STATE_OVERHEAD
+const size_t MultiDFA::CACHE_STATE_OVERHEAD;
+
+// Constructor.
+MultiDFA::MultiDFA(const vector<CompiledDFA> &patterns)
+    : cache_budget(DEFAULT_CACHE_BUDGET), cache_stats(), dead_state(-1),
+      patterns(patterns) {
+  find_symbol_classes();
+  clear_cache();
+}
+
+// Constructor.
+MultiDFA::MultiDFA(const vector<DFA> &patterns)
+    : cache_budget(DEFAULT_CACHE_BUDGET), cache_stats(), dead_state(-1) {
+  for (int i = 0; i < patterns.size(); ++i)
+    this->patterns.push_back(CompiledDFA(patterns[i]));
+  find_symbol_classes();
+  clear_cache();
+}
+
+// Find every pattern accepting the given bytes.
+void MultiDFA::match(const char *str, size_t len, vector<int> *matched) {
+  matched->clear();
+  int n_patterns = patterns.size();
+  t_tuple.resize(n_patterns);
+  for (int i = 0; i < n_patterns; ++i)
+    t_tuple[i] = patterns[i].get_start_state();
+  int q = cache_state(t_tuple);
+  for (size_t i = 0; i < len; ++i) {
+    // Every pattern is dead, nothing can be accepted anymore
+    if (q == dead_state) return;
+    int c = symbol_classes[static_cast<unsigned char>(str[i])];
+    int next = cache_transitions[q * n_classes + c];
+    if (next >= 0) {
+      ++cache_stats.hits;
+    } else {
+      ++cache_stats.misses;
+      unsigned char e = representatives[c];
+      for (int k = 0; k < n_patterns; ++k)
+        t_tuple[k] = patterns[k].tf(cache_tuples[q * n_patterns + k], e);
+      unsigned long long flushes = cache_stats.flushes;
+      next = cache_state(t_tuple);
+      // The cache may have been flushed, in which case q is gone
+      if (cache_stats.flushes == flushes)
+        cache_transitions[q * n_classes + c] = next;
+    }
+    q = next;
+  }
+  matched->assign(match_ids.begin() + match_offsets[q],
+                  match_ids.begin() + match_offsets[q + 1]);
+}
+
+// Split the bytes into symbol classes refining those of every pattern.
+void MultiDFA::find_symbol_classes() {
+  // Bytes having the same symbol class in every pattern share a class
+  std::map<vector<int>, int> signatures;
+  vector<int> signature(patterns.size());
+  representatives.clear();
+  for (int e = 0; e < 256; ++e) {
+    for (int i = 0; i < patterns.size(); ++i)
+      signature[i] = patterns[i].get_symbol_class(e);
+    std::map<vector<int>, int>::iterator it = signatures.find(signature);
+    if (it == signatures.end()) {
+      it = signatures.insert(std::make_pair(signature,
+                                            representatives.size())).first;
+      representatives.push_back(e);
+    }
+    symbol_classes[e] = it->second;
+  }
+  n_classes = representatives.size();
+}
+
+// Get the product state of a tuple, adding it to the cache if needed.
+int MultiDFA::cache_state(const vector<state> &tuple) {
+  std::unordered_map<vector<state>, int, StatesHash>::iterator it =
+      cache_index.find(tuple);
+  if (it != cache_index.end()) return it->second;
+  // The tuple is stored twice: as a key and in cache_tuples
+  size_t bytes = CACHE_STATE_OVERHEAD + 2 * tuple.size() * sizeof(state) +
+                 n_classes * sizeof(int);
+  if (cache_stats.bytes + bytes > cache_budget && cache_stats.states > 0) {
+    clear_cache();
+    ++cache_stats.flushes;
+  }
+  int q = cache_index.size();
+  cache_index[tuple] = q;
+  cache_tuples.insert(cache_tuples.end(), tuple.begin(), tuple.end());
+  bool dead = true;
+  for (int i = 0; i < tuple.size(); ++i) {
+    if (patterns[i].is_accepting_state(tuple[i])) match_ids.push_back(i);
+    if (tuple[i] != patterns[i].get_dead_state()) dead = false;
+  }
+  match_offsets.push_back(match_ids.size());
+  if (dead) dead_state = q;
+  cache_transitions.resize(cache_transitions.size() + n_classes, -1);
+  ++cache_stats.states;
+  cache_stats.bytes += bytes +
+      (match_offsets[q + 1] - match_offsets[q]) * sizeof(int);
+  return q;
+}
+
+// Empty the cache.
+void MultiDFA::clear_cache() {
+  cache_index.clear();
+  cache_tuples.clear();
+  cache_transitions.clear();
+  match_ids.clear();
+  match_offsets.assign(1, 0);
+  dead_state = -1;
+  cache_stats.states = 0;
+  cache_stats.bytes = 0;
+}
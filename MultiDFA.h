@@ -0,0 +1,161 @@
+//
+// MultiDFA.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef MULTI_DFA_H_
+#define MULTI_DFA_H_
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./CompiledDFA.h"
+#include "./DFA.h"
+#include "./StateCache.h"
+
+using std::string;
+using std::vector;
+
+/**
+ Many DFAs (patterns) matched together in a single pass over the input.
+
+ A state of the combined automaton is the tuple of the states of every
+ pattern, i.e. the product automaton, and it accepts the set of patterns
+ whose own state is accepting. Bytes are first mapped to symbol classes which
+ refine the symbol classes of every pattern.
+
+ The product may have as many states as the product of the pattern sizes, so
+ it is constructed lazily: a tuple is added, and a transition computed, only
+ when some input reaches it. Computed states are kept in a cache having a
+ memory budget, the cache is flushed once it is full. Once every pattern is
+ in its dead state the scan stops early.
+
+ match() updates the cache, so an object can only be used by one thread at a
+ time.
+ */
+class MultiDFA {
+ public:
+  // Statistics of the product state cache
+  typedef ::CacheStats CacheStats;
+
+  // Default memory budget of the cache in bytes
+  static const size_t DEFAULT_CACHE_BUDGET = 8 << 20;
+
+  /**
+   Constructor.
+   @param patterns Patterns, pattern i is reported as i
+   */
+  explicit MultiDFA(const vector<CompiledDFA> &patterns);
+
+  /**
+   Constructor.
+   @param patterns Patterns, pattern i is reported as i
+   */
+  explicit MultiDFA(const vector<DFA> &patterns);
+
+  /**
+   Find every pattern accepting the given bytes.
+   @param str Bytes to evaluate
+   @param len Total bytes
+   @param matched Output: accepting patterns in increasing order
+   */
+  void match(const char *str, size_t len, vector<int> *matched);
+
+  /**
+   Find every pattern accepting the given string.
+   @param str String to evaluate
+   @param matched Output: accepting patterns in increasing order
+   */
+  void match(const string &str, vector<int> *matched) {
+    match(str.data(), str.size(), matched);
+  }
+
+  /**
+   Set the memory budget of the cache. The cache is flushed whenever adding a
+   product state would exceed the budget.
+   @param bytes Budget in bytes
+   */
+  void set_cache_budget(size_t bytes) { cache_budget = bytes; }
+
+  /**
+   Get statistics of the cache.
+   @return Statistics
+   */
+  const CacheStats &get_cache_stats() const { return cache_stats; }
+
+  /**
+   Get total patterns.
+   @return Total patterns
+   */
+  int get_n_patterns() const { return patterns.size(); }
+
+  /**
+   Get total symbol classes.
+   @return Total symbol classes
+   */
+  int get_n_classes() const { return n_classes; }
+
+ private:
+  // Estimated bookkeeping per cached product state in bytes
+  static const size_t CACHE_STATE_OVERHEAD = 64;
+
+  /**
+   Split the bytes into symbol classes refining those of every pattern.
+   */
+  void find_symbol_classes();
+
+  /**
+   Get the product state of a tuple, adding it to the cache if needed.
+   @param tuple State (row offset) of every pattern
+   @return Product state
+   */
+  int cache_state(const vector<state> &tuple);
+
+  /**
+   Empty the cache.
+   */
+  void clear_cache();
+
+  // Memory budget of the cache in bytes
+  size_t cache_budget;
+
+  // Cache statistics
+  CacheStats cache_stats;
+
+  // Product state of a tuple
+  std::unordered_map<vector<state>, int, StatesHash> cache_index;
+
+  // Tuple of each product state, i.e. tuples[q * n_patterns + i]
+  vector<state> cache_tuples;
+
+  // Accepting patterns of each product state, i.e.
+  // match_ids[match_offsets[q]..match_offsets[q + 1]]
+  vector<int> match_offsets;
+  vector<int> match_ids;
+
+  // Transitions, row-major with one column per symbol class, -1 if not
+  // computed yet
+  vector<int> cache_transitions;
+
+  // Product state where every pattern is dead, -1 if not cached
+  int dead_state;
+
+  // Total symbol classes
+  int n_classes;
+
+  // Patterns
+  vector<CompiledDFA> patterns;
+
+  // A byte of each symbol class
+  vector<unsigned char> representatives;
+
+  // Byte to symbol class map
+  int symbol_classes[256];
+
+  // Temporary tuple
+  vector<state> t_tuple;
+};
+
+#endif  // MULTI_DFA_H_
@@ -0,0 +1,60 @@
+//
+// MultiDFA_example.cpp
+// FiniteAutomataLabExperiments
+//
+// Compile the regular expressions given as arguments (default: a few over
+// {0, 1}) and report every one of them matching a string in a single pass,
+// `-1` to exit
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DFA.h"
+#include "MultiDFA.h"
+#include "NFA_to_DFA.h"
+#include "Regex.h"
+
+using std::cin;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+int main(int argc, char *argv[]) {
+  vector<string> patterns;
+  for (int i = 1; i < argc; ++i) patterns.push_back(argv[i]);
+  if (patterns.empty()) {
+    patterns.push_back("(0|1)*011(0|1)*");
+    patterns.push_back("(0|1)*0");
+    patterns.push_back("1(0|1)*");
+    patterns.push_back("(0*10*1)*0*");
+  }
+  vector<DFA> dfas;
+  for (int i = 0; i < patterns.size(); ++i) {
+    Regex regex(patterns[i]);
+    if (!regex.is_valid()) {
+      cout << "Invalid pattern " << patterns[i] << ": " << regex.get_error()
+           << endl;
+      return 1;
+    }
+    NFAToDFA ntd = regex.to_NFAToDFA();
+    dfas.push_back(ntd.to_DFA());
+    cout << i << ": " << patterns[i] << endl;
+  }
+  MultiDFA multi(dfas);
+  cout << endl;
+
+  string str;
+  vector<int> matched;
+  while (true) {
+    cout << "Enter a string: "; cin >> str;
+    if (str == "-1") break;
+    multi.match(str, &matched);
+    cout << "Matched:";
+    for (int i = 0; i < matched.size(); ++i) cout << " " << matched[i];
+    cout << (matched.empty() ? " none" : "") << "\n" << endl;
+  }
+  return 0;
+}
@@ -8,18 +8,126 @@
 
 #include "./NFA_to_DFA.h"
 
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
 #include <vector>
 #include <string>
 
+#include "./StateCache.h"
+#include "./Stats.h"
+#include "./ThreadPool.h"
+
 using std::cout;
 using std::endl;
+using std::map;
 using std::string;
 using std::vector;
 
 // Init EPSILON
 const input_symbol NFAToDFA::EPSILON = '\0';
 
+// Init MIN_PARALLEL_LEVEL
+const int NFAToDFA::MIN_PARALLEL_LEVEL;
+
+// Init PARALLEL_CHUNK
+const int NFAToDFA::PARALLEL_CHUNK;
+
+// Shard of the table of new subsets used by construct_parallel().
+struct NFAToDFA::Shard {
+  // Guards the members below
+  std::mutex mutex;
+
+  // New subsets of the level
+  vector< vector<state> > sets;
+
+  // Hash of each subset
+  vector<size_t> hashes;
+
+  // Where each subset was first reached: (index of visited_states) *
+  // (total DFA input symbols) + (index of the DFA input symbol)
+  vector<int64_t> first_reached;
+
+  // Open addressing hash table of indices of sets, -1 if empty
+  vector<int> index;
+
+  // DFA state of each subset, once the level is done
+  vector<int> ids;
+
+  /**
+   Add a subset if new, keeping where it was first reached.
+   @param states Subset, taken if new
+   @param h Hash of the subset
+   @param reached Where the subset was reached
+   @return Index of sets
+   */
+  int intern(vector<state> *states, size_t h, int64_t reached) {
+    size_t mask = index.size() - 1;
+    if (!index.empty()) {
+      for (size_t k = h & mask; index[k] >= 0; k = (k + 1) & mask) {
+        int i = index[k];
+        if (hashes[i] == h && sets[i] == *states) {
+          first_reached[i] = std::min(first_reached[i], reached);
+          return i;
+        }
+      }
+    }
+    int i = sets.size();
+    sets.push_back(vector<state>());
+    sets.back().swap(*states);
+    hashes.push_back(h);
+    first_reached.push_back(reached);
+    // Keep the load factor at most 1/2
+    if (sets.size() * 2 > index.size()) {
+      index.assign(index.empty() ? 16 : index.size() * 2, -1);
+      mask = index.size() - 1;
+      for (int j = 0; j < sets.size(); ++j) {
+        size_t k = hashes[j] & mask;
+        while (index[k] >= 0) k = (k + 1) & mask;
+        index[k] = j;
+      }
+    } else {
+      size_t k = h & mask;
+      while (index[k] >= 0) k = (k + 1) & mask;
+      index[k] = i;
+    }
+    return i;
+  }
+
+  /**
+   Remove every subset.
+   */
+  void clear() {
+    sets.clear();
+    hashes.clear();
+    first_reached.clear();
+    index.clear();
+    ids.clear();
+  }
+};
+
+// Scratch space of a thread of construct_parallel().
+struct NFAToDFA::Worker {
+  // Per NFA state marks for successors()
+  vector<unsigned int> marks;
+
+  // Current mark
+  unsigned int mark;
+
+  // Successors of a subset
+  vector<state> out;
+
+  Worker() : mark(0) {}
+};
+
 // Constructor.
 NFAToDFA::NFAToDFA(int n_states, const vector<input_symbol> &input_symbols,
                    const vector<state> &start_state,
@@ -28,33 +136,357 @@ NFAToDFA::NFAToDFA(int n_states, const vector<input_symbol> &input_symbols,
                    start_state(start_state), accepting_states(accepting_states),
                    n_input_symbols(input_symbols.size()) {
   has_epsilon = false;
+  // The last duplicate symbol is preferred
+  std::fill(symbol_index, symbol_index + 256, -1);
+  for (int j = 0; j < n_input_symbols; ++j) {
+    symbol_index[static_cast<unsigned char>(input_symbols[j])] = j;
+    if (input_symbols[j] != EPSILON)
+      dfa_input_symbols.push_back(input_symbols[j]);
+  }
+  marks.assign(n_states, 0);
+  mark = 0;
   while (n_states--) {
     vector< vector< state > > t_row(n_input_symbols);
     transition_table.push_back(t_row);
   }
 }
 
+// Constructor.
+NFAToDFA::NFAToDFA(const ENFA &nfa)
+                   : n_states(nfa.get_n_states()),
+                   input_symbols(nfa.get_input_symbols()),
+                   start_state(1, nfa.get_start_state()),
+                   accepting_states(nfa.get_accepting_states()),
+                   n_input_symbols(nfa.get_input_symbols().size()) {
+  has_epsilon = false;
+  // The last duplicate symbol is preferred
+  std::fill(symbol_index, symbol_index + 256, -1);
+  for (int j = 0; j < n_input_symbols; ++j) {
+    symbol_index[static_cast<unsigned char>(input_symbols[j])] = j;
+    if (input_symbols[j] != EPSILON)
+      dfa_input_symbols.push_back(input_symbols[j]);
+  }
+  marks.assign(n_states, 0);
+  mark = 0;
+  transition_table.resize(n_states);
+  for (int i = 0; i < n_states; ++i) {
+    transition_table[i].resize(n_input_symbols);
+    for (int j = 0; j < n_input_symbols; ++j) {
+      transition_table[i][j] = nfa.get_transitions(i, j);
+      if (input_symbols[j] == EPSILON && !transition_table[i][j].empty())
+        has_epsilon = true;
+    }
+  }
+}
+
 // Construct DFA from NFA.
 void NFAToDFA::construct(const vector<state> &q) {
-  if (visited(q)) return;
-  add_to_visited(q);
+  FA_STATS_TIMER("nfa_to_dfa.construct");
+  vector<state> start = canonical(q);
+  if (visited(start)) return;
+  // visited_states doubles as the worklist: every set of states from `i`
+  // onwards is yet to be explored
+  int i = visited_states.size();
+  add_to_visited(&start);
+  int k = dfa_input_symbols.size();
+  vector<int> symbol_indices(k), same;
+  for (int j = 0; j < k; ++j)
+    symbol_indices[j] = get_index_by_input_symbol(dfa_input_symbols[j]);
+  find_symbol_classes(&same);
   vector<state> tmp_state;
-  for (int i = 0; i < n_input_symbols; ++i) {
-    tmp_state = tf(q, input_symbols[i]);
-    if (tmp_state.size() != 0 && !visited(tmp_state)) {
-      construct(tmp_state);
+  for ( ; i < visited_states.size(); ++i) {
+    size_t row = dfa_transitions.size();
+    for (int j = 0; j < k; ++j) {
+      // Symbols having the same NFA column share the successors
+      if (same[j] != j) {
+        dfa_transitions.push_back(dfa_transitions[row + same[j]]);
+        continue;
+      }
+      successors(visited_states[i], symbol_indices[j], &marks, &mark,
+                 &tmp_state);
+      FA_STATS_COUNT("nfa_to_dfa.transitions", 1);
+      if (tmp_state.size() == 0) {
+        dfa_transitions.push_back(DFA::NO_STATE);
+        continue;
+      }
+      int found = find_visited(tmp_state);
+      if (found < 0) {
+        found = visited_states.size();
+        add_to_visited(&tmp_state);
+      }
+      dfa_transitions.push_back(found);
     }
   }
 }
 
-// Get index by input symbol.
-int NFAToDFA::get_index_by_input_symbol(input_symbol e) {
-  int n = n_input_symbols;
-  while (n--)
-    if (e == input_symbols[n]) return n;
+// Construct DFA from NFA using multiple threads.
+void NFAToDFA::construct_parallel(const vector<state> &q, int n_threads) {
+  if (n_threads <= 0) n_threads = std::thread::hardware_concurrency();
+  if (n_threads <= 0) n_threads = 1;
+  ThreadPool pool(n_threads);
+  construct_parallel(q, &pool);
+}
+
+// Construct DFA from NFA using the threads of a pool.
+void NFAToDFA::construct_parallel(const vector<state> &q, ThreadPool *pool) {
+  FA_STATS_TIMER("nfa_to_dfa.construct_parallel");
+  vector<state> start = canonical(q);
+  if (visited(start)) return;
+  int first = visited_states.size();
+  add_to_visited(&start);
+  // More shards than threads keep the lock contention low
+  int n_shards = 8 * pool->get_n_threads();
+  std::unique_ptr<Shard[]> shards(new Shard[n_shards]);
+  // Marks are allocated once rather than by every thread on every level
+  std::unique_ptr<Worker[]> workers(new Worker[pool->get_n_threads()]);
+  for (int t = 0; t < pool->get_n_threads(); ++t)
+    workers[t].marks.assign(n_states, 0);
+  vector<int64_t> rows;
+  vector< std::pair<int64_t, int64_t> > order;
+  vector<int> same;
+  find_symbol_classes(&same);
+  while (first < visited_states.size()) {
+    int last = visited_states.size();
+    for (int s = 0; s < n_shards; ++s) shards[s].clear();
+    explore_level(first, last, pool, workers.get(), same, shards.get(),
+                  n_shards, &rows);
+    // Number the new subsets in the order construct() would have found them
+    order.clear();
+    for (int s = 0; s < n_shards; ++s) {
+      shards[s].ids.resize(shards[s].sets.size());
+      for (int i = 0; i < shards[s].sets.size(); ++i)
+        order.push_back(std::make_pair(shards[s].first_reached[i],
+                                       static_cast<int64_t>(i) * n_shards + s));
+    }
+    std::sort(order.begin(), order.end());
+    for (int i = 0; i < order.size(); ++i) {
+      Shard &shard = shards[order[i].second % n_shards];
+      int local = order[i].second / n_shards;
+      shard.ids[local] = visited_states.size();
+      add_to_visited(&shard.sets[local]);
+    }
+    for (size_t i = 0; i < rows.size(); ++i) {
+      int64_t handle = -rows[i] - 1;
+      dfa_transitions.push_back(rows[i] >= 0 ? static_cast<state>(rows[i]) :
+          shards[handle % n_shards].ids[handle / n_shards]);
+    }
+    FA_STATS_RECORD("nfa_to_dfa.level_size", last - first);
+    first = last;
+  }
+}
+
+// Explore a level of subsets for construct_parallel().
+void NFAToDFA::explore_level(int first, int last, ThreadPool *pool,
+                             Worker *workers, const vector<int> &same,
+                             Shard *shards, int n_shards,
+                             vector<int64_t> *rows) {
+  int k = dfa_input_symbols.size();
+  vector<int> symbol_indices(k);
+  for (int j = 0; j < k; ++j)
+    symbol_indices[j] = get_index_by_input_symbol(dfa_input_symbols[j]);
+  rows->assign(static_cast<size_t>(last - first) * k, 0);
+  std::atomic<int> next(first);
+  // Chunks of the level are claimed until none is left
+  auto work = [&](Worker *worker) {
+    vector<state> &out = worker->out;
+    while (true) {
+      int begin = next.fetch_add(PARALLEL_CHUNK);
+      if (begin >= last) break;
+      int end = std::min(last, begin + PARALLEL_CHUNK);
+      for (int i = begin; i < end; ++i) {
+        int64_t *cells = &(*rows)[static_cast<size_t>(i - first) * k];
+        for (int j = 0; j < k; ++j) {
+          int64_t &row = cells[j];
+          // Symbols having the same NFA column share the successors
+          if (same[j] != j) {
+            row = cells[same[j]];
+            continue;
+          }
+          successors(visited_states[i], symbol_indices[j], &worker->marks,
+                     &worker->mark, &out);
+          FA_STATS_COUNT("nfa_to_dfa.transitions", 1);
+          if (out.empty()) {
+            row = DFA::NO_STATE;
+            continue;
+          }
+          int found = find_visited(out);
+          if (found >= 0) {
+            row = found;
+            continue;
+          }
+          size_t h = hash_states(out);
+          int s = (h >> 40) % n_shards;
+          std::lock_guard<std::mutex> lock(shards[s].mutex);
+          int local =
+              shards[s].intern(&out, h, static_cast<int64_t>(i) * k + j);
+          row = -(static_cast<int64_t>(local) * n_shards + s) - 1;
+        }
+      }
+    }
+  };
+  if (last - first < MIN_PARALLEL_LEVEL || pool->get_n_threads() == 1) {
+    work(&workers[0]);
+    return;
+  }
+  // One loop per thread, each claiming chunks until the level is done
+  pool->parallel_for(pool->get_n_threads(), 1,
+                     [&](size_t begin, size_t end) {
+    for (size_t t = begin; t < end; ++t) work(&workers[t]);
+  });
+}
+
+// Get the constructed DFA.
+DFA NFAToDFA::to_DFA() {
+  vector<state> start = canonical(start_state);
+  int dfa_start_state = find_visited(start);
+  if (dfa_start_state < 0) {
+    dfa_start_state = visited_states.size();
+    construct(start_state);
+  }
+  int dfa_n_states = visited_states.size();
+  int dfa_n_input_symbols = dfa_input_symbols.size();
+  vector<state> dfa_accepting_states;
+  for (int i = 0; i < dfa_n_states; ++i)
+    if (has_accepting_state(visited_states[i]))
+      dfa_accepting_states.push_back(i);
+  DFA dfa(dfa_n_states, dfa_input_symbols, dfa_start_state,
+          dfa_accepting_states);
+  for (int i = 0; i < dfa_n_states; ++i)
+    for (int j = 0; j < dfa_n_input_symbols; ++j)
+      dfa.set_state(i, dfa_input_symbols[j],
+                    dfa_transitions[i * dfa_n_input_symbols + j]);
+  return dfa;
+}
+
+// Get memory used by subset construction.
+size_t NFAToDFA::get_memory_usage() const {
+  size_t bytes = visited_states.capacity() * sizeof(vector<state>) +
+                 visited_hashes.capacity() * sizeof(size_t) +
+                 visited_index.capacity() * sizeof(int) +
+                 dfa_transitions.capacity() * sizeof(state);
+  for (int i = 0; i < visited_states.size(); ++i)
+    bytes += visited_states[i].capacity() * sizeof(state);
+  return bytes;
+}
+
+// Add a set of states to the visited list.
+void NFAToDFA::add_to_visited(vector<state> *states) {
+  FA_STATS_RECORD("nfa_to_dfa.subset_size", states->size());
+  visited_hashes.push_back(hash_states(*states));
+  visited_states.push_back(vector<state>());
+  visited_states.back().swap(*states);
+  // Keep the load factor at most 1/2
+  if (visited_states.size() * 2 > visited_index.size()) {
+    visited_index.assign(visited_index.empty() ? 64 : visited_index.size() * 2,
+                         -1);
+    size_t mask = visited_index.size() - 1;
+    for (int i = 0; i < visited_states.size(); ++i) {
+      size_t k = visited_hashes[i] & mask;
+      while (visited_index[k] >= 0) k = (k + 1) & mask;
+      visited_index[k] = i;
+    }
+  } else {
+    size_t mask = visited_index.size() - 1;
+    size_t k = visited_hashes.back() & mask;
+    while (visited_index[k] >= 0) k = (k + 1) & mask;
+    visited_index[k] = visited_states.size() - 1;
+  }
+}
+
+// Sort a set of states, remove duplicates and add the e-closures.
+vector<state> NFAToDFA::canonical(const vector<state> &states) {
+  if (has_epsilon && e_closures.empty()) find_e_closures();
+  next_mark();
+  vector<state> out_state;
+  for (int i = 0; i < states.size(); ++i) {
+    if (has_epsilon) {
+      const vector<state> &closure = e_closures[states[i]];
+      for (int k = 0; k < closure.size(); ++k) {
+        if (marks[closure[k]] != mark) {
+          marks[closure[k]] = mark;
+          out_state.push_back(closure[k]);
+        }
+      }
+    } else if (marks[states[i]] != mark) {
+      marks[states[i]] = mark;
+      out_state.push_back(states[i]);
+    }
+  }
+  std::sort(out_state.begin(), out_state.end());
+  return out_state;
+}
+
+// Find e-closures of all NFA states.
+void NFAToDFA::find_e_closures() {
+  FA_STATS_TIMER("nfa_to_dfa.find_e_closures");
+  int index_e = get_index_by_input_symbol(EPSILON);
+  e_closures.assign(n_states, vector<state>());
+  vector<state> stack;
+  for (int q = 0; q < n_states; ++q) {
+    // Depth-first search, marks prevent visiting a state twice
+    next_mark();
+    vector<state> &closure = e_closures[q];
+    marks[q] = mark;
+    stack.push_back(q);
+    while (!stack.empty()) {
+      state p = stack.back();
+      stack.pop_back();
+      closure.push_back(p);
+      const vector<state> &e_states = transition_table[p][index_e];
+      for (int k = 0; k < e_states.size(); ++k) {
+        if (marks[e_states[k]] != mark) {
+          marks[e_states[k]] = mark;
+          stack.push_back(e_states[k]);
+        }
+      }
+    }
+    std::sort(closure.begin(), closure.end());
+    FA_STATS_RECORD("nfa_to_dfa.closure_size", closure.size());
+  }
+}
+
+// Get index of a visited set of states (DFA state).
+int NFAToDFA::find_visited(const vector<state> &states) const {
+  if (visited_index.empty()) return -1;
+  FA_STATS_TIMER("nfa_to_dfa.find_visited");
+  size_t h = hash_states(states);
+  size_t mask = visited_index.size() - 1;
+  for (size_t k = h & mask; visited_index[k] >= 0; k = (k + 1) & mask) {
+    int i = visited_index[k];
+    FA_STATS_COUNT("nfa_to_dfa.find_visited.probes", 1);
+    if (visited_hashes[i] == h && visited_states[i] == states) return i;
+  }
   return -1;
 }
 
+// Get index by input symbol.
+int NFAToDFA::get_index_by_input_symbol(input_symbol e) const {
+  return symbol_index[static_cast<unsigned char>(e)];
+}
+
+// Find the DFA input symbols having identical NFA columns.
+void NFAToDFA::find_symbol_classes(vector<int> *same) const {
+  int k = dfa_input_symbols.size();
+  same->resize(k);
+  // A column is keyed by the size and the sorted targets of each of its cells
+  map< vector<state>, int > column_to_symbol;
+  vector<state> column, cell;
+  for (int j = 0; j < k; ++j) {
+    int index_e = get_index_by_input_symbol(dfa_input_symbols[j]);
+    column.clear();
+    for (int q = 0; q < n_states; ++q) {
+      cell = transition_table[q][index_e];
+      std::sort(cell.begin(), cell.end());
+      cell.erase(std::unique(cell.begin(), cell.end()), cell.end());
+      column.push_back(cell.size());
+      column.insert(column.end(), cell.begin(), cell.end());
+    }
+    (*same)[j] =
+        column_to_symbol.insert(std::make_pair(column, j)).first->second;
+  }
+  FA_STATS_RECORD("nfa_to_dfa.symbol_classes", column_to_symbol.size());
+}
+
 // Whether a set of states (DFA state) has at least one end state.
 bool NFAToDFA::has_accepting_state(const vector<state> &states) {
   for (int i = 0; i < states.size(); ++i) {
@@ -73,28 +505,33 @@ bool NFAToDFA::is_accepting_state(state q) {
 
 // Output DFA transision table to the standard output
 void NFAToDFA::print_DFA_transition_table() {
-  int dfa_n_input_symbols = n_input_symbols;
-  if (!has_epsilon) --dfa_n_input_symbols;
-  cout << "DFA Transition Table\n      ";
+  // Epsilon transitions are folded into the sets of states
+  int dfa_n_input_symbols = dfa_input_symbols.size();
+  int width = std::max<int>(1, state_label(visited_states.size() - 1).size());
+  cout << "DFA Transition Table\n     " << string(width, ' ');
+  for (int j = 0; j < dfa_n_input_symbols; ++j)
+    cout << " | " << dfa_input_symbols[j] << string(width - 1, ' ');
+  cout << " |\n-----" << string(width, '-');
   for (int j = 0; j < dfa_n_input_symbols; ++j)
-    cout << " | " << (input_symbols[j] == EPSILON ? 'E': input_symbols[j]);
-  cout << " |\n------";
-  for (int j = 0; j < dfa_n_input_symbols; ++j) cout << "----";
+    cout << "---" << string(width, '-');
   cout << "--\n";
-  vector<state> tmp_state;
+  vector<state> dfa_start_state = canonical(start_state);
   for (int j = 0; j < visited_states.size(); ++j) {
-    cout << (start_state == visited_states[j] ? "-> " : "   ")
+    string label = state_label(j);
+    cout << (dfa_start_state == visited_states[j] ? "-> " : "   ")
          << (has_accepting_state(visited_states[j]) ? "* ": "  ")
-         << static_cast<char>('A' + j);
+         << label << string(width - label.size(), ' ');
     for (int i = 0; i < dfa_n_input_symbols; ++i) {
-        cout << " | " << states_to_state(
-          tf(visited_states[j], input_symbols[i]));
+      // Rows are recorded by construct(), the empty set has no label
+      state s = dfa_transitions[j * dfa_n_input_symbols + i];
+      label = (s == DFA::NO_STATE ? string() : state_label(s));
+      cout << " | " << label << string(width - label.size(), ' ');
     }
     cout << " |\n";
   }
   cout << "\nWhere:\n";
   for (int i = 0; i < visited_states.size(); ++i) {
-    cout << states_to_state(visited_states[i]) << " = { ";
+    cout << state_label(i) << " = { ";
     int k = 0;
     for ( ; k < visited_states[i].size()-1; ++k)
       cout << 'q' << visited_states[i][k] << ", ";
@@ -152,41 +589,80 @@ void NFAToDFA::print_visited() {
 // Insert data into transition table.
 void NFAToDFA::set_state(state q, input_symbol e, state s) {
   if (e == EPSILON) has_epsilon = true;
+  // e-closures are found again when needed
+  e_closures.clear();
   transition_table[q][get_index_by_input_symbol(e)].push_back(s);
 }
 
-// Assign a set of NFA states (DFA state) a letter.
-char NFAToDFA::states_to_state(const vector<state> &states) {
-  for (int i = 0; i < visited_states.size(); ++i) {
-    if (visited_states[i] == states) return static_cast<char>('A'+i);
+// Insert many destination states at once, allocating only once.
+void NFAToDFA::set_states(state q, input_symbol e, const state *first,
+                          const state *last) {
+  if (e == EPSILON && first != last) has_epsilon = true;
+  e_closures.clear();
+  vector<state> &cell = transition_table[q][get_index_by_input_symbol(e)];
+  cell.reserve(cell.size() + (last - first));
+  cell.insert(cell.end(), first, last);
+}
+
+// Move to the next mark, clearing all the marks if it wraps around.
+void NFAToDFA::next_mark(vector<unsigned int> *marks, unsigned int *mark) {
+  if (++*mark == 0) {
+    std::fill(marks->begin(), marks->end(), 0);
+    *mark = 1;
   }
-  return '\0';  // To suppress compile time warning
+}
+
+// Assign a set of NFA states (DFA state) a label.
+string NFAToDFA::states_to_state(const vector<state> &states) {
+  int i = find_visited(states);
+  if (i >= 0) return state_label(i);
+  return string();
+}
+
+// Label of a DFA state: A to Z, then AA, AB and so on.
+string NFAToDFA::state_label(int i) {
+  string label;
+  for (++i; i > 0; i = (i - 1) / 26)
+    label.insert(label.begin(), static_cast<char>('A' + (i - 1) % 26));
+  return label;
 }
 
 // Transition function.
 vector<state> NFAToDFA::tf(const vector<state> &q, input_symbol e) {
+  if (has_epsilon && e_closures.empty()) find_e_closures();
   vector<state> tmp_state;
-  int index_e = get_index_by_input_symbol(e);
+  successors(q, get_index_by_input_symbol(e), &marks, &mark, &tmp_state);
+  return tmp_state;
+}
+
+// Find the successors of a set of states.
+void NFAToDFA::successors(const vector<state> &q, int index_e,
+                          vector<unsigned int> *marks, unsigned int *mark,
+                          vector<state> *out) const {
+  next_mark(marks, mark);
+  out->clear();
+  bool close = has_epsilon && input_symbols[index_e] != EPSILON;
   for (int i = 0; i < q.size(); ++i) {
-    for (int j = 0; j < transition_table[q[i]][index_e].size(); ++j) {
-      bool found = false;
-      for (int k = 0; k < tmp_state.size(); ++k) {
-        if (tmp_state[k] == transition_table[q[i]][index_e][j]) {
-          found = true;
-          break;
+    const vector<state> &targets = transition_table[q[i]][index_e];
+    for (int j = 0; j < targets.size(); ++j) {
+      if (close) {
+        const vector<state> &closure = e_closures[targets[j]];
+        for (int k = 0; k < closure.size(); ++k) {
+          if ((*marks)[closure[k]] != *mark) {
+            (*marks)[closure[k]] = *mark;
+            out->push_back(closure[k]);
+          }
         }
+      } else if ((*marks)[targets[j]] != *mark) {
+        (*marks)[targets[j]] = *mark;
+        out->push_back(targets[j]);
       }
-      if (!found) tmp_state.push_back(transition_table[q[i]][index_e][j]);
     }
   }
-  return tmp_state;
+  std::sort(out->begin(), out->end());
 }
 
 // Whether the given set of state is visited already.
 bool NFAToDFA::visited(const vector<state> &states) {
-  for (int i = 0; i < visited_states.size(); ++i) {
-    if (visited_states[i] == states)
-      return true;
-  }
-  return false;
+  return find_visited(states) >= 0;
 }
@@ -9,13 +9,22 @@
 #ifndef NFA_TO_DFA_H_
 #define NFA_TO_DFA_H_
 
-#include <vector>
+#include <stdint.h>
+
+#include <cstddef>
 #include <string>
+#include <vector>
+
+#include "./DFA.h"
+#include "./eClosures.h"
+
+class ThreadPool;
 
 // Define types
 typedef unsigned int state;
 typedef char input_symbol;
 
+using std::string;
 using std::vector;
 
 /**
@@ -40,6 +49,12 @@ class NFAToDFA {
            const vector<state> &start_states,
            const vector<state> &accepting_states);
 
+  /**
+   Constructor.
+   @param nfa Automaton to convert, e.g. from ENFA::remove_epsilon()
+   */
+  explicit NFAToDFA(const ENFA &nfa);
+
   /**
    Construct DFA from NFA.
 
@@ -48,12 +63,67 @@ class NFAToDFA {
    a result, provided the DFA doesn't contain all possible subsets of the NFA
    states, the exponential growth can be reduced significantly.
 
-   NOTE: This is a recursive function.
+   Subsets are explored breadth-first from a worklist. Each subset is kept
+   sorted and closed under epsilon transitions, and is looked up in a hash
+   set, so a subset is never stored twice.
+
+   Every DFA transition is recorded once while exploring, see to_DFA().
 
    @param q Initialized with start state (DFA state)
    */
   void construct(const vector<state> &q);
 
+  /**
+   Construct DFA from NFA using multiple threads.
+
+   Subsets are explored breadth-first one level at a time. The subsets of a
+   level are split into chunks which idle threads claim from a shared
+   counter. A thread finds the successors of its subsets for every input
+   symbol and looks them up in the visited sets, which are read-only during
+   a level. Subsets which are new are interned in a table of independently
+   locked shards, remembering where each was first reached. Once a level is
+   done, the new subsets are numbered in the order construct() would have
+   found them, so the DFA is exactly the same as the one of construct() for
+   any number of threads.
+
+   Small levels are explored by the calling thread alone. The threads are
+   those of a pool started for this call only.
+   @param q Initialized with start state (DFA state)
+   @param n_threads Total threads, zero for the number of cores
+   */
+  void construct_parallel(const vector<state> &q, int n_threads = 0);
+
+  /**
+   Construct DFA from NFA using the threads of a pool, as construct_parallel()
+   does with a pool of its own.
+   @param q Initialized with start state (DFA state)
+   @param pool Thread pool
+   */
+  void construct_parallel(const vector<state> &q, ThreadPool *pool);
+
+  /**
+   Get the constructed DFA, construct() is called with the start state first
+   if it wasn't already.
+
+   DFA state i is the i-th visited set of states, missing transitions (i.e. to
+   the empty set) are DFA::NO_STATE. EPSILON is not part of the alphabet.
+   @return Executable DFA
+   */
+  DFA to_DFA();
+
+  /**
+   Get total DFA states found so far, i.e. total visited sets of states.
+   @return Total DFA states
+   */
+  int get_n_visited() const { return visited_states.size(); }
+
+  /**
+   Get memory used by subset construction: the visited sets of states, their
+   hash table and the DFA transition table.
+   @return Total bytes, approximately
+   */
+  size_t get_memory_usage() const;
+
   /**
    Output DFA transision table to the standard output
 
@@ -81,11 +151,22 @@ class NFAToDFA {
    */
   void set_state(state q, input_symbol e, state s);
 
+  /**
+   Insert many destination states at once, allocating only once.
+   @param q Current NFA state
+   @param e Input symbol to set
+   @param first First destination state
+   @param last End of the destination states
+   */
+  void set_states(state q, input_symbol e, const state *first,
+                  const state *last);
+
   /**
    Transition function.
    @param q Current states
    @param e Input symbol from the current state
-   @return Next states based on the input symbol
+   @return Next states based on the input symbol, sorted and closed under
+           epsilon transitions
    */
   vector<state> tf(const vector<state> &q, input_symbol e);
 
@@ -93,12 +174,36 @@ class NFAToDFA {
   // Accepting states
   const vector<state> accepting_states;
 
+  // e-closure of each NFA state, sorted (only if has_epsilon)
+  vector< vector<state> > e_closures;
+
+  // Open addressing hash table of indices of visited_states, -1 if empty
+  vector<int> visited_index;
+
+  // Hash of each set of states in visited_states
+  vector<size_t> visited_hashes;
+
+  // Per NFA state marks used to merge sets of states without duplicates
+  vector<unsigned int> marks;
+
+  // Current mark, see marks
+  unsigned int mark;
+
   // Whether the any has any epsilon transition
   bool has_epsilon;
 
   // Input symbols: EPSILON if exists has to be the last symbol
   const vector<input_symbol> input_symbols;
 
+  // Index of each byte in input_symbols, -1 if not an input symbol
+  int symbol_index[256];
+
+  // Input symbols of the DFA, i.e. input symbols without EPSILON
+  vector<input_symbol> dfa_input_symbols;
+
+  // DFA transition table: row-major, one row per explored visited set
+  vector<state> dfa_transitions;
+
   // Total states
   const int n_states;
 
@@ -111,23 +216,110 @@ class NFAToDFA {
   // Transition table
   vector< vector< vector<state> > > transition_table;
 
+  // Subsets of a level below which construct_parallel() uses a single thread
+  static const int MIN_PARALLEL_LEVEL = 256;
+
+  // Subsets claimed by a thread at a time in construct_parallel()
+  static const int PARALLEL_CHUNK = 32;
+
+  /**
+   Shard of the table of new subsets used by construct_parallel().
+   */
+  struct Shard;
+
+  /**
+   Scratch space of a thread of construct_parallel(), kept from level to
+   level.
+   */
+  struct Worker;
+
   // Visited states: subset of total states and each is a state of DFA
   vector< vector<state> > visited_states;
 
   /**
    Add a set of states to the visited list.
-   @param states Set of states (DFA state)
+   @param states Set of states (DFA state), moved to the list so it is left
+                 empty
+   */
+  void add_to_visited(vector<state> *states);
+
+  /**
+   Explore a level of subsets for construct_parallel().
+   @param first Index of the first subset of the level in visited_states
+   @param last Index after the last subset of the level in visited_states
+   @param pool Thread pool, only used for levels of at least
+               MIN_PARALLEL_LEVEL subsets
+   @param workers Scratch space of each thread of the pool
+   @param same First DFA input symbol having the column of each, see
+               find_symbol_classes()
+   @param shards Table of new subsets, empty
+   @param n_shards Total shards
+   @param rows Output: transitions of the level, row-major, either a visited
+               subset, DFA::NO_STATE, or -(entry + 1) for the entry of a new
+               subset as in Shard
+   */
+  void explore_level(int first, int last, ThreadPool *pool, Worker *workers,
+                     const vector<int> &same, Shard *shards, int n_shards,
+                     vector<int64_t> *rows);
+
+  /**
+   Find the successors of a set of states.
+   @param q Sorted set of states
+   @param index_e Index of the input symbol
+   @param marks Per NFA state marks
+   @param mark Current mark
+   @param out Output: sorted set of states, closed under epsilon transitions
+              unless the input symbol is EPSILON
+   */
+  void successors(const vector<state> &q, int index_e,
+                  vector<unsigned int> *marks, unsigned int *mark,
+                  vector<state> *out) const;
+
+  /**
+   Find e-closures of all NFA states.
+   */
+  void find_e_closures();
+
+  /**
+   Sort a set of states, remove duplicates and add the e-closures.
+   @param states Set of NFA states
+   @return Sorted set of states closed under epsilon transitions
+   */
+  vector<state> canonical(const vector<state> &states);
+
+  /**
+   Get index of a visited set of states (DFA state).
+   @param states Sorted set of states closed under epsilon transitions
+   @return Index of visited_states, -1 if not visited
+   */
+  int find_visited(const vector<state> &states) const;
+
+  /**
+   Move to the next mark, clearing all the marks if it wraps around.
    */
-  void add_to_visited(vector<state> states) {
-    visited_states.push_back(states);
-  }
+  void next_mark() { next_mark(&marks, &mark); }
+
+  /**
+   Move to the next mark, clearing all the marks if it wraps around.
+   @param marks Per NFA state marks
+   @param mark Current mark
+   */
+  static void next_mark(vector<unsigned int> *marks, unsigned int *mark);
 
   /**
    Get index by input symbol.
    @param e Input symbol
-   @return Index of input_symbols array
+   @return Index of input_symbols array, -1 if not an input symbol
    */
-  int get_index_by_input_symbol(input_symbol e);
+  int get_index_by_input_symbol(input_symbol e) const;
+
+  /**
+   Find the DFA input symbols having identical NFA columns, which therefore
+   lead every set of states to the same successors.
+   @param same Output: for each DFA input symbol, the first DFA input symbol
+               having the same column (itself if none comes before it)
+   */
+  void find_symbol_classes(vector<int> *same) const;
 
   /**
    Whether a set of states (DFA state) has at least one accepting state.
@@ -144,10 +336,18 @@ class NFAToDFA {
   bool is_accepting_state(state q);
 
   /**
-   Assign a set of NFA states (DFA state) a letter.
+   Assign a set of NFA states (DFA state) a label.
    @param states Set of states (DFA state)
+   @return Label, empty if not visited
+   */
+  string states_to_state(const vector<state> &states);
+
+  /**
+   Label of a DFA state: A to Z, then AA, AB and so on.
+   @param i Index of visited_states
+   @return Label
    */
-  char states_to_state(const vector<state> &states);
+  static string state_label(int i);
 
   /**
    Whether the given set of state is visited already.
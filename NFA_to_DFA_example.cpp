@@ -10,10 +10,13 @@
 #include<vector>
 #include<string>
 
+#include "DFA.h"
 #include "NFA_to_DFA.h"
 
 using std::cin;
 using std::cout;
+using std::endl;
+using std::string;
 using std::vector;
 
 int main() {
@@ -43,5 +46,15 @@ int main() {
   ntd.construct(start_state);
   // ntd.print_visited();
   ntd.print_DFA_transition_table();
+
+  // Match strings using the constructed DFA, `-1` to exit
+  DFA dfa = ntd.to_DFA();
+  string str;
+  while (true) {
+    cout << "Enter a string: "; cin >> str;
+    if (str == "-1") break;
+    bool status = dfa.evaluate(str);
+    cout << "Status: " << (status ? "Accepted" : "Rejected") << "\n" << endl;
+  }
   return 0;
 }
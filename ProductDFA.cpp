@@ -0,0 +1,163 @@
+//
+// ProductDFA.cpp
+// FiniteAutomataLabExperiments
+//
+
+#include "./ProductDFA.h"
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "./Stats.h"
+
+using std::string;
+using std::vector;
+
+// Constructor.
+ProductDFA::ProductDFA(const DFA &a, const DFA &b, Operation operation)
+    : a(a), b(b), operation(operation), dead_state(-1) {
+  init();
+}
+
+// Constructor.
+ProductDFA::ProductDFA(const CompiledDFA &a, const CompiledDFA &b,
+                       Operation operation)
+    : a(a), b(b), operation(operation), dead_state(-1) {
+  init();
+}
+
+// Evaluate the given bytes, adding the pairs they reach.
+bool ProductDFA::evaluate(const char *str, size_t len) {
+  FA_STATS_COUNT("product_dfa.evaluate.calls", 1);
+  int q = start_state;
+  for (size_t i = 0; i < len; ++i) {
+    // Nothing can be accepted anymore
+    if (q == dead_state) return false;
+    q = tf(q, symbol_classes[static_cast<unsigned char>(str[i])]);
+  }
+  return accepting[q];
+}
+
+// Build the DFA of the pairs reachable from the start pair.
+DFA ProductDFA::to_DFA(bool minimize) {
+  // Reachable pairs but the dead one in breadth-first order, and their
+  // numbers in the DFA
+  vector<int> order;
+  vector<int> number(accepting.size(), -1);
+  vector<bool> used(n_classes, false);
+  if (start_state != dead_state) {
+    order.push_back(start_state);
+    number[start_state] = 0;
+  }
+  for (int i = 0; i < order.size(); ++i) {
+    for (int c = 0; c < n_classes; ++c) {
+      int s = tf(order[i], c);
+      if (s == dead_state) continue;
+      used[c] = true;
+      if (s >= number.size()) number.resize(accepting.size(), -1);
+      if (number[s] < 0) {
+        number[s] = order.size();
+        order.push_back(s);
+      }
+    }
+  }
+  FA_STATS_RECORD("product_dfa.reachable_states", order.size());
+  vector<input_symbol> input_symbols;
+  for (int e = 0; e < 256; ++e)
+    if (used[symbol_classes[e]])
+      input_symbols.push_back(static_cast<input_symbol>(e));
+  vector<state> accepting_states;
+  for (int i = 0; i < order.size(); ++i)
+    if (accepting[order[i]]) accepting_states.push_back(i);
+  // An empty language still needs a start state
+  DFA dfa(order.empty() ? 1 : order.size(), input_symbols, 0,
+          accepting_states);
+  for (int i = 0; i < order.size(); ++i) {
+    for (int j = 0; j < input_symbols.size(); ++j) {
+      int s = tf(order[i], symbol_classes[static_cast<unsigned char>(
+          input_symbols[j])]);
+      dfa.set_state(i, input_symbols[j],
+                    s == dead_state ? DFA::NO_STATE : number[s]);
+    }
+  }
+  if (minimize) return dfa.minimize();
+  return dfa;
+}
+
+// Whether the operation accepts given whether each DFA accepts.
+bool ProductDFA::combine(Operation operation, bool a, bool b) {
+  switch (operation) {
+    case OPERATION_INTERSECTION: return a && b;
+    case OPERATION_UNION: return a || b;
+    case OPERATION_DIFFERENCE: return a && !b;
+    default: return a != b;
+  }
+}
+
+// Split the bytes into symbol classes refining those of both DFAs.
+void ProductDFA::init() {
+  // Bytes having the same symbol class in both DFAs share a class
+  std::map<std::pair<int, int>, int> signatures;
+  for (int e = 0; e < 256; ++e) {
+    std::pair<int, int> signature(a.get_symbol_class(e),
+                                  b.get_symbol_class(e));
+    std::map<std::pair<int, int>, int>::iterator it =
+        signatures.find(signature);
+    if (it == signatures.end()) {
+      it = signatures.insert(std::make_pair(signature,
+                                            representatives.size())).first;
+      representatives.push_back(e);
+    }
+    symbol_classes[e] = it->second;
+  }
+  n_classes = representatives.size();
+  a.find_live_states(&live_a);
+  b.find_live_states(&live_b);
+  start_state = find_state(a.get_start_state(), b.get_start_state());
+}
+
+// Get the pair of a state of each DFA, adding it if new.
+int ProductDFA::find_state(state qa, state qb) {
+  // States which cannot reach an accepting state all behave as dead
+  if (!live_a[qa / a.get_n_classes()]) qa = a.get_dead_state();
+  if (!live_b[qb / b.get_n_classes()]) qb = b.get_dead_state();
+  // Whether the pair may still be accepted, a dead DFA only rejects
+  bool alive = false;
+  for (int va = 0; va <= (qa != a.get_dead_state()); ++va)
+    for (int vb = 0; vb <= (qb != b.get_dead_state()); ++vb)
+      if (combine(operation, va, vb)) alive = true;
+  if (!alive) {
+    qa = a.get_dead_state();
+    qb = b.get_dead_state();
+  }
+  uint64_t key = static_cast<uint64_t>(qa) << 32 | qb;
+  std::unordered_map<uint64_t, int>::iterator it = pair_index.find(key);
+  if (it != pair_index.end()) return it->second;
+  int q = accepting.size();
+  pair_index[key] = q;
+  pairs.push_back(qa);
+  pairs.push_back(qb);
+  accepting.push_back(combine(operation, a.is_accepting_state(qa),
+                              b.is_accepting_state(qb)));
+  // The dead pair loops on itself
+  transitions.resize(transitions.size() + n_classes, alive ? -1 : q);
+  if (!alive) dead_state = q;
+  FA_STATS_COUNT("product_dfa.states", 1);
+  return q;
+}
+
+// Transition function, computing the transition if needed.
+int ProductDFA::tf(int q, int c) {
+  int s = transitions[q * n_classes + c];
+  if (s >= 0) return s;
+  unsigned char e = representatives[c];
+  s = find_state(a.tf(pairs[2 * q], e), b.tf(pairs[2 * q + 1], e));
+  transitions[q * n_classes + c] = s;
+  return s;
+}
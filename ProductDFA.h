@@ -0,0 +1,180 @@
+//
+// ProductDFA.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef PRODUCT_DFA_H_
+#define PRODUCT_DFA_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./CompiledDFA.h"
+#include "./DFA.h"
+
+using std::string;
+using std::vector;
+
+/**
+ Boolean combination of two DFAs, e.g. strings matching A and not B.
+
+ A state of the combination is a pair of states, one of each DFA, i.e. the
+ product automaton, and whether it accepts is the operation applied to both.
+ The product may have |A| x |B| states, so pairs are only built on demand:
+ evaluate() adds a pair, and computes a transition, only when some input
+ reaches it, and to_DFA() adds the pairs reachable from the start pair.
+ Memory and time are thus proportional to the reachable part of the product.
+ Bytes are first mapped to symbol classes refining those of both DFAs.
+
+ States of a DFA which can no longer reach an accepting state all behave as
+ its dead state and are replaced by it, and pairs which can no longer be
+ accepted whatever the input (e.g. A dead in an intersection) are replaced by
+ one dead pair, so evaluate() stops as soon as it is reached.
+
+ Complement is not a product, see DFA::complement(). evaluate() updates the
+ pairs, so an object can only be used by one thread at a time.
+ */
+class ProductDFA {
+ public:
+  /**
+   Boolean operations.
+   */
+  enum Operation {
+    // Accepted by both A and B
+    OPERATION_INTERSECTION,
+    // Accepted by A, B or both
+    OPERATION_UNION,
+    // Accepted by A but not by B
+    OPERATION_DIFFERENCE,
+    // Accepted by exactly one of A and B
+    OPERATION_SYMMETRIC_DIFFERENCE
+  };
+
+  /**
+   Constructor.
+   @param a First DFA
+   @param b Second DFA
+   @param operation Operation
+   */
+  ProductDFA(const DFA &a, const DFA &b, Operation operation);
+
+  /**
+   Constructor.
+   @param a First compiled DFA
+   @param b Second compiled DFA
+   @param operation Operation
+   */
+  ProductDFA(const CompiledDFA &a, const CompiledDFA &b, Operation operation);
+
+  /**
+   Evaluate the given string.
+   @param str String to evaluate
+   @return True on accepted, false on rejected
+   */
+  bool evaluate(const string &str) { return evaluate(str.data(), str.size()); }
+
+  /**
+   Evaluate the given bytes, adding the pairs they reach.
+   @param str Bytes to evaluate
+   @param len Total bytes
+   @return True on accepted, false on rejected
+   */
+  bool evaluate(const char *str, size_t len);
+
+  /**
+   Build the DFA of the pairs reachable from the start pair (breadth-first).
+   Its input symbols are the bytes on which some pair goes to a pair other
+   than the dead one, transitions to the dead pair are DFA::NO_STATE.
+   @param minimize Whether to minimize the DFA, see DFA::minimize()
+   @return DFA with start state 0
+   */
+  DFA to_DFA(bool minimize = false);
+
+  /**
+   Whether the operation accepts given whether each DFA accepts.
+   @param operation Operation
+   @param a Whether the first DFA accepts
+   @param b Whether the second DFA accepts
+   @return True if accepted, false otherwise
+   */
+  static bool combine(Operation operation, bool a, bool b);
+
+  /**
+   Get total pairs built so far, the dead pair included.
+   @return Total pairs
+   */
+  int get_n_states() const { return accepting.size(); }
+
+  /**
+   Get total symbol classes.
+   @return Total symbol classes
+   */
+  int get_n_classes() const { return n_classes; }
+
+ private:
+  /**
+   Split the bytes into symbol classes refining those of both DFAs, and find
+   the live states of both.
+   */
+  void init();
+
+  /**
+   Get the pair of a state of each DFA, adding it if new.
+   @param qa State of the first DFA (row offset)
+   @param qb State of the second DFA (row offset)
+   @return Pair
+   */
+  int find_state(state qa, state qb);
+
+  /**
+   Transition function, computing the transition if needed.
+   @param q Current pair
+   @param c Symbol class
+   @return Next pair
+   */
+  int tf(int q, int c);
+
+  // Operands
+  CompiledDFA a, b;
+
+  // Whether each state (state number) of each DFA can reach an accepting
+  // state
+  vector<bool> live_a, live_b;
+
+  // Operation
+  Operation operation;
+
+  // Byte to symbol class map
+  int symbol_classes[256];
+
+  // A byte of each symbol class
+  vector<unsigned char> representatives;
+
+  // Total symbol classes
+  int n_classes;
+
+  // Pair of each key, the key having the first state in the high 32 bits
+  std::unordered_map<uint64_t, int> pair_index;
+
+  // States of each pair, i.e. pairs[2 * q] and pairs[2 * q + 1]
+  vector<state> pairs;
+
+  // Whether each pair is accepting
+  vector<bool> accepting;
+
+  // Transitions, row-major with one column per symbol class, -1 if not
+  // computed yet
+  vector<int> transitions;
+
+  // Start pair
+  int start_state;
+
+  // Pair which is never accepted whatever the input, -1 if not built yet
+  int dead_state;
+};
+
+#endif  // PRODUCT_DFA_H_
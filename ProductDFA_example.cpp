@@ -0,0 +1,62 @@
+//
+// ProductDFA_example.cpp
+// FiniteAutomataLabExperiments
+//
+// Match any string with substring `011` but not `111` by combining the DFAs
+// of both substrings, `-1` to exit
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DFA.h"
+#include "ProductDFA.h"
+
+using std::cin;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+int main() {
+  vector<input_symbol> input_symbols;
+  input_symbols.push_back('0');
+  input_symbols.push_back('1');
+  vector<state> accepting_states;
+  accepting_states.push_back(3);
+  // Strings with substring `011`, see DFA_example.cpp
+  DFA str_011(4, input_symbols, 0, accepting_states);
+  str_011.set_state(0, '0', 1);
+  str_011.set_state(0, '1', 0);
+  str_011.set_state(1, '0', 1);
+  str_011.set_state(1, '1', 2);
+  str_011.set_state(2, '0', 1);
+  str_011.set_state(2, '1', 3);
+  str_011.set_state(3, '0', 3);
+  str_011.set_state(3, '1', 3);
+  // Strings with substring `111`
+  DFA str_111(4, input_symbols, 0, accepting_states);
+  str_111.set_state(0, '0', 0);
+  str_111.set_state(0, '1', 1);
+  str_111.set_state(1, '0', 0);
+  str_111.set_state(1, '1', 2);
+  str_111.set_state(2, '0', 0);
+  str_111.set_state(2, '1', 3);
+  str_111.set_state(3, '0', 3);
+  str_111.set_state(3, '1', 3);
+
+  ProductDFA product(str_011, str_111, ProductDFA::OPERATION_DIFFERENCE);
+  DFA dfa = product.to_DFA(true);
+  cout << "Minimized product of 4 x 4 states:" << endl;
+  dfa.print_transition_table();
+
+  string str;
+  while (true) {
+    cout << "Enter a string: "; cin >> str;
+    if (str == "-1") break;
+    bool status = dfa.evaluate(str, true);
+    cout << "Status: " << (status ? "Accepted" : "Rejected") << "\n" << endl;
+  }
+  return 0;
+}
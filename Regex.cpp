@@ -0,0 +1,278 @@
+//
+// Regex.cpp
+// FiniteAutomataLabExperiments
+//
+
+#include "./Regex.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// Init MAX_DEPTH
+const int Regex::MAX_DEPTH;
+
+// Constructor.
+Regex::Regex(const string &pattern, const vector<input_symbol> &input_symbols)
+    : input_symbols(input_symbols), pattern(pattern), pos(0), depth(0) {
+  Node root = parse_alternation();
+  if (pos < pattern.size()) fail("unmatched `)`");
+  if (!is_valid()) {
+    symbols.clear();
+    follow.clear();
+    return;
+  }
+  // Alphabet: the given one, or every byte listed by the pattern
+  vector<bool> alphabet(256, false);
+  if (this->input_symbols.empty()) {
+    for (int p = 0; p < position_sets.size(); ++p)
+      for (int e = 0; e < 256; ++e)
+        if (position_sets[p][e]) alphabet[e] = true;
+    for (int e = 1; e < 256; ++e)
+      if (alphabet[e]) this->input_symbols.push_back(static_cast<char>(e));
+  } else {
+    for (int j = 0; j < input_symbols.size(); ++j)
+      alphabet[static_cast<unsigned char>(input_symbols[j])] = true;
+    for (int p = 0; p < position_sets.size(); ++p) {
+      if (position_negated[p]) continue;
+      for (int e = 0; e < 256; ++e) {
+        if (position_sets[p][e] && !alphabet[e]) {
+          // Report the offset of the position, parsing is over
+          pos = position_offsets[p];
+          fail(string("symbol `") + static_cast<char>(e) +
+               "` is not an input symbol");
+        }
+      }
+    }
+    if (!is_valid()) {
+      symbols.clear();
+      follow.clear();
+      return;
+    }
+  }
+  alphabet[static_cast<unsigned char>(ENFA::EPSILON)] = false;
+  // Symbols of each position, in the order of the alphabet
+  symbols.resize(position_sets.size());
+  for (int p = 0; p < position_sets.size(); ++p) {
+    for (int j = 0; j < this->input_symbols.size(); ++j) {
+      unsigned char e = this->input_symbols[j];
+      if (alphabet[e] && position_sets[p][e] != position_negated[p])
+        symbols[p].push_back(this->input_symbols[j]);
+    }
+  }
+  position_sets.clear();
+  position_negated.clear();
+  position_offsets.clear();
+  for (int p = 0; p < follow.size(); ++p) {
+    std::sort(follow[p].begin(), follow[p].end());
+    follow[p].erase(std::unique(follow[p].begin(), follow[p].end()),
+                    follow[p].end());
+  }
+  // State 0 is the start state, position p is state p + 1
+  if (root.nullable) accepting_states.push_back(0);
+  for (int i = 0; i < root.last.size(); ++i)
+    accepting_states.push_back(root.last[i] + 1);
+  std::sort(accepting_states.begin(), accepting_states.end());
+  // Transitions of the start state go to the first positions
+  follow.insert(follow.begin(), root.first);
+}
+
+// Get the NFA as an ENFA (without epsilon transitions).
+ENFA Regex::to_ENFA() const {
+  ENFA enfa(get_n_states(), input_symbols, 0, accepting_states);
+  for (int q = 0; q < follow.size(); ++q)
+    for (int i = 0; i < follow[q].size(); ++i) {
+      const vector<input_symbol> &e = symbols[follow[q][i]];
+      for (int j = 0; j < e.size(); ++j)
+        enfa.set_state(q, e[j], follow[q][i] + 1);
+    }
+  enfa.findEClosures();
+  return enfa;
+}
+
+// Get the NFA for subset construction.
+NFAToDFA Regex::to_NFAToDFA() const {
+  NFAToDFA ntd(get_n_states(), input_symbols, vector<state>(1, 0),
+               accepting_states);
+  for (int q = 0; q < follow.size(); ++q)
+    for (int i = 0; i < follow[q].size(); ++i) {
+      const vector<input_symbol> &e = symbols[follow[q][i]];
+      for (int j = 0; j < e.size(); ++j)
+        ntd.set_state(q, e[j], follow[q][i] + 1);
+    }
+  return ntd;
+}
+
+// Get the NFA with one transition per position.
+SymbolicNFA Regex::to_SymbolicNFA() const {
+  SymbolicNFA nfa(get_n_states(), vector<state>(1, 0), accepting_states);
+  vector<ByteSet> sets(symbols.size());
+  for (int p = 0; p < symbols.size(); ++p)
+    for (int j = 0; j < symbols[p].size(); ++j)
+      sets[p].add(static_cast<unsigned char>(symbols[p][j]));
+  for (int q = 0; q < follow.size(); ++q)
+    for (int i = 0; i < follow[q].size(); ++i)
+      nfa.set_state(q, sets[follow[q][i]], follow[q][i] + 1);
+  return nfa;
+}
+
+// Parse an alternation: concatenations separated by `|`.
+Regex::Node Regex::parse_alternation() {
+  Node node = parse_concatenation();
+  while (pos < pattern.size() && pattern[pos] == '|') {
+    ++pos;
+    Node right = parse_concatenation();
+    node.nullable = node.nullable || right.nullable;
+    node.first.insert(node.first.end(), right.first.begin(), right.first.end());
+    node.last.insert(node.last.end(), right.last.begin(), right.last.end());
+  }
+  return node;
+}
+
+// Parse a concatenation: repetitions one after another.
+Regex::Node Regex::parse_concatenation() {
+  Node node;
+  node.nullable = true;
+  while (pos < pattern.size() && pattern[pos] != '|' && pattern[pos] != ')') {
+    Node right = parse_repetition();
+    add_follow(node.last, right.first);
+    if (node.nullable)
+      node.first.insert(node.first.end(), right.first.begin(),
+                        right.first.end());
+    if (!right.nullable) node.last.clear();
+    node.last.insert(node.last.end(), right.last.begin(), right.last.end());
+    node.nullable = node.nullable && right.nullable;
+  }
+  return node;
+}
+
+// Parse a repetition: an atom followed by any number of `*`, `+` or `?`.
+Regex::Node Regex::parse_repetition() {
+  Node node = parse_atom();
+  while (pos < pattern.size()) {
+    char op = pattern[pos];
+    if (op != '*' && op != '+' && op != '?') break;
+    ++pos;
+    if (op != '?') add_follow(node.last, node.first);
+    if (op != '+') node.nullable = true;
+  }
+  return node;
+}
+
+// Parse an atom: a symbol, a character class or a group.
+Regex::Node Regex::parse_atom() {
+  vector<bool> set(256, false);
+  int offset = pos;
+  if (pos == pattern.size()) {
+    fail("unexpected end of pattern");
+    return position(set, false, offset);
+  }
+  switch (pattern[pos]) {
+    case '(': {
+      if (depth == MAX_DEPTH) {
+        // Groups are parsed recursively, stop before the stack overflows
+        fail("groups nested too deeply");
+        pos = pattern.size();
+        return position(set, false, offset);
+      }
+      ++pos;
+      ++depth;
+      Node node = parse_alternation();
+      --depth;
+      if (pos < pattern.size() && pattern[pos] == ')')
+        ++pos;
+      else
+        fail("missing `)`");
+      return node;
+    }
+    case '[': {
+      ++pos;
+      bool negated = parse_class(&set);
+      return position(set, negated, offset);
+    }
+    case '.':
+      ++pos;
+      return position(set, true, offset);
+    case '*':
+    case '+':
+    case '?':
+      fail(string("nothing to repeat before `") + pattern[pos] + "`");
+      ++pos;
+      return position(set, false, offset);
+    default:
+      set[static_cast<unsigned char>(parse_symbol())] = true;
+      return position(set, false, offset);
+  }
+}
+
+// Parse a character class, the opening `[` is consumed already.
+bool Regex::parse_class(vector<bool> *set) {
+  bool negated = pos < pattern.size() && pattern[pos] == '^';
+  if (negated) ++pos;
+  // `]` right after `[` or `[^` is taken literally
+  bool first = true;
+  while (pos < pattern.size() && (pattern[pos] != ']' || first)) {
+    first = false;
+    unsigned char lo = parse_symbol(), hi = lo;
+    if (pos + 1 < pattern.size() && pattern[pos] == '-' &&
+        pattern[pos + 1] != ']') {
+      ++pos;
+      hi = parse_symbol();
+      if (hi < lo) fail("invalid range in character class");
+    }
+    for (int e = lo; e <= hi; ++e) (*set)[e] = true;
+  }
+  if (pos < pattern.size())
+    ++pos;
+  else
+    fail("missing `]`");
+  return negated;
+}
+
+// Read a possibly escaped symbol.
+input_symbol Regex::parse_symbol() {
+  char e = pattern[pos++];
+  if (e == '\\') {
+    if (pos == pattern.size()) {
+      fail("trailing `\\`");
+      return e;
+    }
+    e = pattern[pos++];
+    if (e == 'n') return '\n';
+    if (e == 't') return '\t';
+  }
+  if (e == ENFA::EPSILON) fail("EPSILON cannot be a symbol");
+  return e;
+}
+
+// Add a new position.
+Regex::Node Regex::position(const vector<bool> &set, bool negated,
+                            int offset) {
+  Node node;
+  node.nullable = false;
+  node.first.push_back(position_sets.size());
+  node.last.push_back(position_sets.size());
+  position_sets.push_back(set);
+  position_negated.push_back(negated);
+  position_offsets.push_back(offset);
+  follow.push_back(vector<int>());
+  return node;
+}
+
+// Record a syntax error, the first error is kept.
+void Regex::fail(const string &message) {
+  if (!error.empty()) return;
+  std::ostringstream out;
+  out << message << " at position " << pos;
+  error = out.str();
+}
+
+// Add positions to the follow sets of some positions.
+void Regex::add_follow(const vector<int> &from, const vector<int> &to) {
+  for (int i = 0; i < from.size(); ++i)
+    follow[from[i]].insert(follow[from[i]].end(), to.begin(), to.end());
+}
@@ -0,0 +1,201 @@
+//
+// Regex.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef REGEX_H_
+#define REGEX_H_
+
+#include <string>
+#include <vector>
+
+#include "./NFA_to_DFA.h"
+#include "./SymbolicNFA.h"
+#include "./eClosures.h"
+
+using std::string;
+using std::vector;
+
+/**
+ Regular expression compiler.
+
+ A regular expression is compiled to an NFA using Glushkov's (position)
+ construction: every occurrence of a symbol or a character class in the
+ pattern is a position, and for m positions the NFA has exactly m + 1 states
+ (the start state is q0, position i is qi) and no epsilon transitions.
+
+ Supported syntax:
+ - `ab` concatenation, `a|b` alternation, `(a)` grouping
+ - `a*`, `a+`, `a?` repetition
+ - `[abc]`, `[a-z]`, `[^abc]` character classes, `.` any input symbol
+ - `\x` escapes x, `\n` and `\t` are newline and tab
+ */
+class Regex {
+ public:
+  // Most groups nested in one another, deeper patterns are rejected
+  static const int MAX_DEPTH = 1000;
+
+  /**
+   Constructor.
+   @param pattern Regular expression
+   @param input_symbols Input symbols, if empty the symbols used by the
+                        pattern are taken. `.` and `[^...]` match symbols of
+                        this alphabet only.
+   */
+  explicit Regex(const string &pattern,
+                 const vector<input_symbol> &input_symbols =
+                     vector<input_symbol>());
+
+  /**
+   Whether the pattern was compiled successfully.
+   @return True if valid, false otherwise (see get_error())
+   */
+  bool is_valid() const { return error.empty(); }
+
+  /**
+   Get the syntax error.
+   @return Error message with its position, empty if the pattern is valid
+   */
+  const string &get_error() const { return error; }
+
+  /**
+   Get input symbols.
+   @return Input symbols
+   */
+  const vector<input_symbol> &get_input_symbols() const {
+    return input_symbols;
+  }
+
+  /**
+   Get total states, i.e. total positions plus one.
+   @return Total states
+   */
+  int get_n_states() const { return symbols.size() + 1; }
+
+  /**
+   Get the NFA as an ENFA (without epsilon transitions).
+   @return NFA, rejecting everything if the pattern is invalid
+   */
+  ENFA to_ENFA() const;
+
+  /**
+   Get the NFA for subset construction.
+   @return NFA, rejecting everything if the pattern is invalid
+   */
+  NFAToDFA to_NFAToDFA() const;
+
+  /**
+   Get the NFA with one transition per position, labeled with every input
+   symbol the position matches.
+   @return NFA, rejecting everything if the pattern is invalid
+   */
+  SymbolicNFA to_SymbolicNFA() const;
+
+ private:
+  /**
+   Attributes of a subexpression.
+   */
+  struct Node {
+    // Whether it matches the empty string
+    bool nullable;
+    // Positions a match can start with
+    vector<int> first;
+    // Positions a match can end with
+    vector<int> last;
+  };
+
+  // Syntax error
+  string error;
+
+  // Accepting states
+  vector<state> accepting_states;
+
+  // Positions each position can be followed by, after parsing follow[0] is
+  // for the start state and follow[p + 1] for position p
+  vector< vector<int> > follow;
+
+  // Input symbols
+  vector<input_symbol> input_symbols;
+
+  // Pattern
+  const string pattern;
+
+  // Current position in the pattern while parsing
+  int pos;
+
+  // Groups open at the current position while parsing
+  int depth;
+
+  // Input symbols matched by each position
+  vector< vector<input_symbol> > symbols;
+
+  // Bytes listed by each position while parsing
+  vector< vector<bool> > position_sets;
+
+  // Whether each position matches bytes not listed, see position_sets
+  vector<bool> position_negated;
+
+  // Offset in the pattern of each position while parsing
+  vector<int> position_offsets;
+
+  /**
+   Parse an alternation: concatenations separated by `|`.
+   @return Attributes of the subexpression
+   */
+  Node parse_alternation();
+
+  /**
+   Parse a concatenation: repetitions one after another.
+   @return Attributes of the subexpression
+   */
+  Node parse_concatenation();
+
+  /**
+   Parse a repetition: an atom followed by any number of `*`, `+` or `?`.
+   @return Attributes of the subexpression
+   */
+  Node parse_repetition();
+
+  /**
+   Parse an atom: a symbol, a character class or a group.
+   @return Attributes of the subexpression
+   */
+  Node parse_atom();
+
+  /**
+   Parse a character class, the opening `[` is consumed already.
+   @param set Output: whether each byte is listed
+   @return Whether the class is negated
+   */
+  bool parse_class(vector<bool> *set);
+
+  /**
+   Read a possibly escaped symbol.
+   @return Symbol
+   */
+  input_symbol parse_symbol();
+
+  /**
+   Add a new position.
+   @param set Whether each byte is listed
+   @param negated Whether the position matches the input symbols not listed
+   @param offset Offset of the position in the pattern
+   @return Attributes of the position
+   */
+  Node position(const vector<bool> &set, bool negated, int offset);
+
+  /**
+   Record a syntax error, the first error is kept.
+   @param message Error message
+   */
+  void fail(const string &message);
+
+  /**
+   Add positions to the follow sets of some positions.
+   @param from Positions
+   @param to Positions that can follow each of them
+   */
+  void add_follow(const vector<int> &from, const vector<int> &to);
+};
+
+#endif  // REGEX_H_
@@ -0,0 +1,43 @@
+//
+// Regex_example.cpp
+// FiniteAutomataLabExperiments
+//
+// Compile a regular expression (default: strings with substring `011`) to an
+// NFA and match strings using the DFA constructed from it, `-1` to exit
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DFA.h"
+#include "NFA_to_DFA.h"
+#include "Regex.h"
+
+using std::cin;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+int main(int argc, char *argv[]) {
+  Regex regex(argc > 1 ? argv[1] : "(0|1)*011(0|1)*");
+  if (!regex.is_valid()) {
+    cout << "Invalid pattern: " << regex.get_error() << endl;
+    return 1;
+  }
+  NFAToDFA ntd = regex.to_NFAToDFA();
+  ntd.print_NFA_transition_table();
+  DFA dfa = ntd.to_DFA();
+  ntd.print_DFA_transition_table();
+  cout << endl;
+
+  string str;
+  while (true) {
+    cout << "Enter a string: "; cin >> str;
+    if (str == "-1") break;
+    bool status = dfa.evaluate(str);
+    cout << "Status: " << (status ? "Accepted" : "Rejected") << "\n" << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,180 @@
+//
+// Search.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef SEARCH_H_
+#define SEARCH_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Define types
+typedef unsigned int state;
+
+using std::vector;
+
+/**
+ What DFA::search() and ENFA::search() report.
+ */
+enum SearchMode {
+  // Every end offset at which a match ends, with the leftmost start of a
+  // match ending there
+  SEARCH_ALL,
+  // The match ending first, scanning stops as soon as it is seen
+  SEARCH_FIRST,
+  // The match starting first, and among those the longest one. Scanning stops
+  // as soon as no longer match is possible.
+  SEARCH_LEFTMOST_LONGEST
+};
+
+/**
+ A match: the bytes [start, end) of the searched string are accepted.
+ */
+struct Match {
+  size_t start;
+  size_t end;
+};
+
+/**
+ Set of states used by unanchored search, each state with the leftmost start
+ offset it was reached from. Clearing it takes constant time.
+ */
+class SearchSet {
+ public:
+  /**
+   Constructor.
+   @param n_states Total states
+   */
+  explicit SearchSet(int n_states) : index(n_states, 0) {}
+
+  /**
+   Remove every state.
+   */
+  void clear() {
+    states.clear();
+    starts.clear();
+  }
+
+  /**
+   Add a state, keeping the leftmost start if it is already there.
+   @param q State
+   @param start Start offset of the match reaching q
+   */
+  void add(state q, size_t start) {
+    int i = index[q];
+    if (i < states.size() && states[i] == q) {
+      if (start < starts[i]) starts[i] = start;
+      return;
+    }
+    index[q] = states.size();
+    states.push_back(q);
+    starts.push_back(start);
+  }
+
+  /**
+   Remove every state whose start is after the given start.
+   @param start Start offset
+   */
+  void remove_after(size_t start) {
+    int n = 0;
+    for (int i = 0; i < states.size(); ++i) {
+      if (starts[i] > start) continue;
+      index[states[i]] = n;
+      states[n] = states[i];
+      starts[n++] = starts[i];
+    }
+    states.resize(n);
+    starts.resize(n);
+  }
+
+  /**
+   Get total states.
+   @return Total states
+   */
+  int size() const { return states.size(); }
+
+  /**
+   Get a state.
+   @param i Position, less than size()
+   @return State
+   */
+  state get_state(int i) const { return states[i]; }
+
+  /**
+   Get the start offset of a state.
+   @param i Position, less than size()
+   @return Start offset
+   */
+  size_t get_start(int i) const { return starts[i]; }
+
+ private:
+  // Position of each state in states, valid only if states agrees
+  vector<int> index;
+
+  // States in insertion order
+  vector<state> states;
+
+  // Leftmost start offset of each state in states
+  vector<size_t> starts;
+};
+
+/**
+ Unanchored search shared by the automata: a match may start at any offset,
+ so a new thread is started from the start state at every offset.
+ @param len Total bytes to search
+ @param mode What to report
+ @param n_states Total states of the automaton
+ @param add_start Called as add_start(SearchSet *set, size_t offset) to add
+                  the start state(s) for a match starting at offset
+ @param step Called as step(const SearchSet &from, size_t offset, SearchSet
+             *to) to consume the byte at offset
+ @param accepting Called as accepting(state q) to find accepting states
+ @param matches Output: matches in increasing end offset
+ @return True if there is a match, false otherwise
+ */
+template <class AddStart, class Step, class Accepting>
+bool search_threads(size_t len, SearchMode mode, int n_states,
+                    AddStart add_start, Step step, Accepting accepting,
+                    vector<Match> *matches) {
+  matches->clear();
+  SearchSet current(n_states), next(n_states);
+  // Leftmost-longest match so far
+  bool found = false;
+  Match best = {0, 0};
+  for (size_t offset = 0; ; ++offset) {
+    // A match starting here would not be leftmost anymore
+    if (!found) add_start(&current, offset);
+    size_t start = SIZE_MAX;
+    for (int i = 0; i < current.size(); ++i)
+      if (current.get_start(i) < start && accepting(current.get_state(i)))
+        start = current.get_start(i);
+    if (start != SIZE_MAX) {
+      Match match = {start, offset};
+      if (mode == SEARCH_ALL) {
+        matches->push_back(match);
+      } else if (mode == SEARCH_FIRST) {
+        matches->push_back(match);
+        return true;
+      } else {
+        // Only threads starting at or before the match can do better
+        found = true;
+        best = match;
+        current.remove_after(start);
+      }
+    }
+    if (offset == len) break;
+    // No thread is left and none will be started
+    if (found && current.size() == 0) break;
+    next.clear();
+    step(current, offset, &next);
+    std::swap(current, next);
+  }
+  if (found) matches->push_back(best);
+  return !matches->empty();
+}
+
+#endif  // SEARCH_H_
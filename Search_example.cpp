@@ -0,0 +1,55 @@
+//
+// Search_example.cpp
+// FiniteAutomataLabExperiments
+//
+// Compile a regular expression (default: `01*0`) and find where it occurs in
+// lines of text, `-1` to exit
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DFA.h"
+#include "NFA_to_DFA.h"
+#include "Regex.h"
+#include "Search.h"
+
+using std::cin;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+// Output matches as `[start, end)`
+static void print_matches(const char *name, const vector<Match> &matches) {
+  cout << name << ":";
+  for (int i = 0; i < matches.size(); ++i)
+    cout << " [" << matches[i].start << ", " << matches[i].end << ")";
+  cout << (matches.empty() ? " none" : "") << endl;
+}
+
+int main(int argc, char *argv[]) {
+  Regex regex(argc > 1 ? argv[1] : "01*0");
+  if (!regex.is_valid()) {
+    cout << "Invalid pattern: " << regex.get_error() << endl;
+    return 1;
+  }
+  NFAToDFA ntd = regex.to_NFAToDFA();
+  DFA dfa = ntd.to_DFA().minimize();
+
+  string str;
+  vector<Match> matches;
+  while (true) {
+    cout << "Enter a string: "; cin >> str;
+    if (str == "-1") break;
+    dfa.search(str, SEARCH_ALL, &matches);
+    print_matches("All", matches);
+    dfa.search(str, SEARCH_FIRST, &matches);
+    print_matches("First", matches);
+    dfa.search(str, SEARCH_LEFTMOST_LONGEST, &matches);
+    print_matches("Leftmost-longest", matches);
+    cout << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,72 @@
+//
+// StateCache.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef STATE_CACHE_H_
+#define STATE_CACHE_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <vector>
+
+// Define types
+typedef unsigned int state;
+
+using std::vector;
+
+/**
+ Statistics of a cache of states computed on demand, e.g. the lazy DFA of
+ ENFA or the product states of MultiDFA.
+ */
+struct CacheStats {
+  // Transitions found in the cache
+  unsigned long long hits;
+  // Transitions computed, i.e. not found in the cache
+  unsigned long long misses;
+  // Times the cache was full and had to be flushed
+  unsigned long long flushes;
+  // Cached states
+  size_t states;
+  // Estimated memory used by the cache in bytes
+  size_t bytes;
+
+  /**
+   Hit rate of the cache.
+   @return Ratio of hits to total transitions, zero if there were none
+   */
+  double hit_rate() const {
+    return hits + misses == 0 ? 0 :
+        static_cast<double>(hits) / (hits + misses);
+  }
+};
+
+/**
+ Hash a set (or tuple) of states.
+ @param states Set of states
+ @return Hash value, FNV-1a over the states then mixed so that the low bits
+         are usable
+ */
+inline size_t hash_states(const vector<state> &states) {
+  uint64_t h = 14695981039346656037ULL;
+  for (size_t i = 0; i < states.size(); ++i) {
+    h ^= states[i];
+    h *= 1099511628211ULL;
+  }
+  h ^= h >> 29;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 32;
+  return static_cast<size_t>(h);
+}
+
+/**
+ Hash of a set of states for std::unordered_map.
+ */
+struct StatesHash {
+  size_t operator()(const vector<state> &states) const {
+    return hash_states(states);
+  }
+};
+
+#endif  // STATE_CACHE_H_
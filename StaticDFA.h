@@ -0,0 +1,221 @@
+//
+// StaticDFA.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef STATIC_DFA_H_
+#define STATIC_DFA_H_
+
+// The constructor fills the tables with loops, allowed in constexpr functions
+// since C++14 only
+#if __cplusplus < 201402L
+#error "StaticDFA.h requires C++14 or later"
+#endif
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+using std::string;
+
+/**
+ Transition of a StaticDFA.
+ */
+struct StaticTransition {
+  // Current state
+  int from;
+  // Input symbol
+  char symbol;
+  // Next state
+  int to;
+};
+
+/**
+ Narrowest unsigned type holding the given number of states.
+ */
+template <long N_STATES>
+struct StaticStateType {
+  typedef typename std::conditional<
+      N_STATES <= 256, uint8_t,
+      typename std::conditional<N_STATES <= 65536, uint16_t,
+                                uint32_t>::type>::type type;
+};
+
+/**
+ DFA known at compile time.
+
+ The tables are built by a constexpr constructor, so a StaticDFA declared
+ constexpr is laid out by the compiler into read-only data and nothing is done
+ at run time. States are stored in the narrowest type holding N_STATES states
+ plus a dead state, e.g. one byte for up to 255 states. Each row has an entry
+ for all the 256 bytes, so a step is a single load without any symbol class
+ lookup:
+
+     q = transitions[q][byte]
+
+ evaluate() is defined here, hence inlined into the caller where the compiler
+ sees the table contents and can unroll and specialize the loop. It is
+ constexpr too, so patterns may be checked with static_assert.
+
+ Bytes outside of the alphabet and missing transitions lead to the dead
+ state. States out of range fail to compile in a constexpr StaticDFA, and are
+ ignored otherwise. Requires C++14 (e.g. -std=c++14), for the loops of the
+ constexpr constructor.
+
+ Example, strings with substring `011` (see StaticDFA_example.cpp):
+
+     constexpr StaticTransition STR_011_TRANSITIONS[] = {
+       {0, '0', 1}, {0, '1', 0}, {1, '0', 1}, {1, '1', 2},
+       {2, '0', 1}, {2, '1', 3}, {3, '0', 3}, {3, '1', 3}
+     };
+     constexpr int STR_011_ACCEPTING[] = {3};
+     constexpr StaticDFA<4> STR_011(STR_011_TRANSITIONS, 0,
+                                    STR_011_ACCEPTING);
+     static_assert(STR_011.evaluate("0110"), "");
+ */
+template <int N_STATES>
+class StaticDFA {
+ public:
+  // Type of a state
+  typedef typename StaticStateType<N_STATES + 1>::type state_type;
+
+  // Dead state, reached by rejected bytes
+  static const state_type DEAD_STATE = N_STATES;
+
+  /**
+   Constructor.
+   @param transitions Transitions
+   @param start_state Start state
+   @param accepting_states Accepting states
+   */
+  template <size_t N_TRANSITIONS, size_t N_ACCEPTING>
+  constexpr StaticDFA(const StaticTransition (&transitions)[N_TRANSITIONS],
+                      int start_state,
+                      const int (&accepting_states)[N_ACCEPTING])
+      : transitions(), accepting(),
+        start_state(valid_state(start_state)) {
+    for (int q = 0; q <= N_STATES; ++q)
+      for (int e = 0; e < 256; ++e) this->transitions[q][e] = DEAD_STATE;
+    for (size_t i = 0; i < N_TRANSITIONS; ++i) {
+      int from = valid_state(transitions[i].from);
+      int to = valid_state(transitions[i].to);
+      if (from != N_STATES)
+        this->transitions[from][static_cast<unsigned char>(
+            transitions[i].symbol)] = to;
+    }
+    for (size_t i = 0; i < N_ACCEPTING; ++i) {
+      int q = valid_state(accepting_states[i]);
+      if (q != N_STATES) accepting[q] = true;
+    }
+  }
+
+  /**
+   Evaluate the given string.
+   @param str String to evaluate
+   @return True on accepted, false on rejected
+   */
+  bool evaluate(const string &str) const {
+    return evaluate(str.data(), str.size());
+  }
+
+  /**
+   Evaluate the given null-terminated string.
+   @param str String to evaluate
+   @return True on accepted, false on rejected
+   */
+  constexpr bool evaluate(const char *str) const {
+    state_type q = start_state;
+    for ( ; *str != '\0'; ++str) q = tf(q, *str);
+    return accepting[q];
+  }
+
+  /**
+   Evaluate the given bytes.
+   @param str Bytes to evaluate
+   @param len Total bytes
+   @return True on accepted, false on rejected
+   */
+  constexpr bool evaluate(const char *str, size_t len) const {
+    return accepting[run(start_state, str, len)];
+  }
+
+  /**
+   Run the given bytes from some state.
+   @param q Current state
+   @param str Bytes to consume
+   @param len Total bytes
+   @return State after consuming all the bytes
+   */
+  constexpr state_type run(state_type q, const char *str, size_t len) const {
+    size_t i = 0;
+    // Unrolled by four, each step is a single load
+    for ( ; i + 4 <= len; i += 4) {
+      q = tf(q, str[i]);
+      q = tf(q, str[i + 1]);
+      q = tf(q, str[i + 2]);
+      q = tf(q, str[i + 3]);
+    }
+    for ( ; i < len; ++i) q = tf(q, str[i]);
+    return q;
+  }
+
+  /**
+   Transition function.
+   @param q Current state
+   @param e Input symbol
+   @return Next state
+   */
+  constexpr state_type tf(state_type q, char e) const {
+    return transitions[q][static_cast<unsigned char>(e)];
+  }
+
+  /**
+   Find if the given state is an accepting state.
+   @param q State to check for
+   @return True if given state is an accepting state, false otherwise
+   */
+  constexpr bool is_accepting_state(state_type q) const {
+    return accepting[q];
+  }
+
+  /**
+   Get start state.
+   @return Start state
+   */
+  constexpr state_type get_start_state() const { return start_state; }
+
+ private:
+  /**
+   Check a state given to the constructor.
+   @param q State
+   @return The state if in range, the dead state otherwise
+   */
+  static constexpr int valid_state(int q) {
+    return q >= 0 && q < N_STATES ? q : out_of_range();
+  }
+
+  /**
+   Called for out of range states. Not constexpr, so that a constexpr
+   StaticDFA having one fails to compile.
+   @return Dead state
+   */
+  static int out_of_range() { return N_STATES; }
+
+  // Transition table: one row per state plus the dead state, one entry per
+  // byte
+  state_type transitions[N_STATES + 1][256];
+
+  // Whether each state is accepting
+  bool accepting[N_STATES + 1];
+
+  // Start state
+  state_type start_state;
+};
+
+template <int N_STATES>
+const typename StaticDFA<N_STATES>::state_type
+    StaticDFA<N_STATES>::DEAD_STATE;
+
+#endif  // STATIC_DFA_H_
@@ -0,0 +1,111 @@
+//
+// StaticDFA_benchmark.cpp
+// FiniteAutomataLabExperiments
+//
+// Throughput of the DFA built at compile time against DFA::evaluate() and the
+// compiled DFA, on one large input and on short records. Requires C++14 (see
+// StaticDFA.h), unlike DFA_benchmark.cpp.
+//
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "AutomataGenerators.h"
+#include "CompiledDFA.h"
+#include "DFA.h"
+#include "StaticDFA.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+// Input size in bytes
+static const size_t INPUT_SIZE = 16 << 20;
+
+// Total records
+static const size_t N_RECORDS = 1 << 20;
+
+// Strings with substring `011` built at compile time, see StaticDFA_example.cpp
+constexpr StaticTransition STR_011_TRANSITIONS[] = {
+  {0, '0', 1}, {0, '1', 0}, {1, '0', 1}, {1, '1', 2},
+  {2, '0', 1}, {2, '1', 3}, {3, '0', 3}, {3, '1', 3}
+};
+constexpr int STR_011_ACCEPTING[] = {3};
+constexpr StaticDFA<4> STATIC_STR_011(STR_011_TRANSITIONS, 0,
+                                      STR_011_ACCEPTING);
+
+// Seconds elapsed since the given time point
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+// Output throughput of a run
+static void report(const char *name, double seconds, bool status) {
+  cout << name << ": " << (INPUT_SIZE / seconds / (1 << 20)) << " MB/s ("
+       << (status ? "Accepted" : "Rejected") << ")" << endl;
+}
+
+// Output throughput of a run over the records
+static void report_records(const char *name, double seconds,
+                           bool matches = true) {
+  cout << name << ": " << (N_RECORDS / seconds / 1e6) << " M records/s"
+       << (matches ? "" : " (MISMATCH)") << endl;
+}
+
+int main() {
+  std::mt19937 rng(2018);
+  vector<input_symbol> binary;
+  binary.push_back('0');
+  binary.push_back('1');
+
+  // Same DFA built at run time, see DFA_example.cpp
+  vector<state> accepting_states;
+  accepting_states.push_back(3);
+  DFA str_011(4, binary, 0, accepting_states);
+  str_011.set_state(0, '0', 1);
+  str_011.set_state(0, '1', 0);
+  str_011.set_state(1, '0', 1);
+  str_011.set_state(1, '1', 2);
+  str_011.set_state(2, '0', 1);
+  str_011.set_state(2, '1', 3);
+  str_011.set_state(3, '0', 3);
+  str_011.set_state(3, '1', 3);
+  CompiledDFA compiled(str_011);
+
+  cout << "Compile-time: substring 011" << endl;
+  string str = random_string(binary, INPUT_SIZE, &rng);
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  bool status = str_011.evaluate(str);
+  report("  DFA::evaluate        ", seconds_since(start), status);
+  start = std::chrono::steady_clock::now();
+  status = compiled.evaluate(str);
+  report("  CompiledDFA::evaluate", seconds_since(start), status);
+  start = std::chrono::steady_clock::now();
+  status = STATIC_STR_011.evaluate(str);
+  report("  StaticDFA::evaluate  ", seconds_since(start), status);
+
+  vector<string> records(N_RECORDS);
+  for (size_t i = 0; i < N_RECORDS; ++i)
+    records[i] = random_string(binary, 8 + rng() % 57, &rng);
+  size_t expected = 0, total = 0, runtime = 0;
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < records.size(); ++i)
+    runtime += str_011.evaluate(records[i]);
+  report_records("  Records: DFA::evaluate        ", seconds_since(start));
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < records.size(); ++i)
+    expected += compiled.evaluate(records[i]);
+  report_records("  Records: CompiledDFA::evaluate", seconds_since(start));
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < records.size(); ++i)
+    total += STATIC_STR_011.evaluate(records[i]);
+  report_records("  Records: StaticDFA::evaluate  ", seconds_since(start),
+                 total == expected && runtime == expected);
+  return 0;
+}
@@ -0,0 +1,48 @@
+//
+// StaticDFA_example.cpp
+// FiniteAutomataLabExperiments
+//
+// Match any string with substring `011` using a DFA built at compile time,
+// `-1` to exit
+//
+
+#include <iostream>
+#include <string>
+
+#include "StaticDFA.h"
+
+using std::cin;
+using std::cout;
+using std::endl;
+using std::string;
+
+// Transition table, see DFA_example.cpp
+constexpr StaticTransition STR_011_TRANSITIONS[] = {
+  {0, '0', 1}, {0, '1', 0},
+  {1, '0', 1}, {1, '1', 2},
+  {2, '0', 1}, {2, '1', 3},
+  {3, '0', 3}, {3, '1', 3}
+};
+
+// Accepting states
+constexpr int STR_011_ACCEPTING[] = {3};
+
+// Tables are in read-only data, nothing is built at run time
+constexpr StaticDFA<4> STR_011(STR_011_TRANSITIONS, 0, STR_011_ACCEPTING);
+
+// The DFA can be checked at compile time
+static_assert(STR_011.evaluate("1011"), "`1011` has substring `011`");
+static_assert(!STR_011.evaluate("1010"), "`1010` has no substring `011`");
+
+int main() {
+  cout << "States are " << sizeof(StaticDFA<4>::state_type) << " byte(s), "
+       << "tables are " << sizeof(STR_011) << " bytes\n" << endl;
+  string str;
+  while (true) {
+    cout << "Enter a string: "; cin >> str;
+    if (str == "-1") break;
+    bool status = STR_011.evaluate(str);
+    cout << "Status: " << (status ? "Accepted" : "Rejected") << "\n" << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,212 @@
+//
+// Stats.cpp
+// FiniteAutomataLabExperiments
+//
+
+#include "./Stats.h"
+
+#include <stdint.h>
+
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+
+using std::string;
+
+const int Stats::N_BUCKETS;
+
+// Every statistic by name, map nodes never move so pointers stay valid
+struct Registry {
+  std::mutex mutex;
+  std::map<string, Stats::Counter> counters;
+  std::map<string, Stats::Timer> timers;
+  std::map<string, Stats::Histogram> histograms;
+};
+
+// The registry, created on first use
+static Registry &registry() {
+  static Registry *r = new Registry();
+  return *r;
+}
+
+// Allocations made by this thread
+static thread_local uint64_t thread_allocations = 0;
+
+#ifdef FA_ENABLE_STATS
+
+// Count every allocation, the rest of the operators forward to these
+void *operator new(size_t size) {
+  ++thread_allocations;
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (p == NULL) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+#endif  // FA_ENABLE_STATS
+
+// Empty a histogram.
+static void clear_histogram(Stats::Histogram *h) {
+  for (int i = 0; i < Stats::N_BUCKETS; ++i) h->buckets[i] = 0;
+  h->count = 0;
+  h->sum = 0;
+  h->min = UINT64_MAX;
+  h->max = 0;
+}
+
+// Add a value to the histogram.
+void Stats::Histogram::add(uint64_t value) {
+  int bucket = 0;
+  for (uint64_t v = value; v != 0; v >>= 1) ++bucket;
+  buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  count.fetch_add(1, std::memory_order_relaxed);
+  sum.fetch_add(value, std::memory_order_relaxed);
+  uint64_t old = min.load(std::memory_order_relaxed);
+  while (value < old && !min.compare_exchange_weak(old, value)) {}
+  old = max.load(std::memory_order_relaxed);
+  while (value > old && !max.compare_exchange_weak(old, value)) {}
+}
+
+// Get a counter, creating it if needed.
+Stats::Counter *Stats::counter(const string &name) {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  return &r.counters[name];
+}
+
+// Get a timer, creating it if needed.
+Stats::Timer *Stats::timer(const string &name) {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  return &r.timers[name];
+}
+
+// Get a histogram, creating it if needed.
+Stats::Histogram *Stats::histogram(const string &name) {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::map<string, Histogram>::iterator it = r.histograms.find(name);
+  if (it != r.histograms.end()) return &it->second;
+  Histogram *h = &r.histograms[name];
+  clear_histogram(h);
+  return h;
+}
+
+// Get the value of a counter.
+uint64_t Stats::get_counter(const string &name) {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::map<string, Counter>::iterator it = r.counters.find(name);
+  return it == r.counters.end() ? 0 : it->second.value.load();
+}
+
+// Get the total time of a timer.
+double Stats::get_timer(const string &name) {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::map<string, Timer>::iterator it = r.timers.find(name);
+  return it == r.timers.end() ? 0 : it->second.nanoseconds.load() / 1e9;
+}
+
+// Get the times a timer was entered.
+uint64_t Stats::get_timer_count(const string &name) {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::map<string, Timer>::iterator it = r.timers.find(name);
+  return it == r.timers.end() ? 0 : it->second.count.load();
+}
+
+// Get total values added to a histogram.
+uint64_t Stats::get_histogram_count(const string &name) {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::map<string, Histogram>::iterator it = r.histograms.find(name);
+  return it == r.histograms.end() ? 0 : it->second.count.load();
+}
+
+// Get the mean of a histogram.
+double Stats::get_histogram_mean(const string &name) {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::map<string, Histogram>::iterator it = r.histograms.find(name);
+  if (it == r.histograms.end() || it->second.count == 0) return 0;
+  return static_cast<double>(it->second.sum) / it->second.count;
+}
+
+// Get allocations made by this thread so far.
+uint64_t Stats::get_thread_allocations() { return thread_allocations; }
+
+// Set every statistic to zero.
+void Stats::reset() {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (std::map<string, Counter>::iterator it = r.counters.begin();
+       it != r.counters.end(); ++it)
+    it->second.value = 0;
+  for (std::map<string, Timer>::iterator it = r.timers.begin();
+       it != r.timers.end(); ++it) {
+    it->second.count = 0;
+    it->second.nanoseconds = 0;
+  }
+  for (std::map<string, Histogram>::iterator it = r.histograms.begin();
+       it != r.histograms.end(); ++it)
+    clear_histogram(&it->second);
+}
+
+// Output every statistic as JSON on one line.
+void Stats::dump_json(std::ostream *out) {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  *out << "{\"counters\": {";
+  const char *separator = "";
+  for (std::map<string, Counter>::iterator it = r.counters.begin();
+       it != r.counters.end(); ++it) {
+    *out << separator << "\"" << it->first << "\": " << it->second.value;
+    separator = ", ";
+  }
+  *out << "}, \"timers\": {";
+  separator = "";
+  for (std::map<string, Timer>::iterator it = r.timers.begin();
+       it != r.timers.end(); ++it) {
+    *out << separator << "\"" << it->first << "\": {\"count\": "
+         << it->second.count << ", \"seconds\": "
+         << it->second.nanoseconds / 1e9 << "}";
+    separator = ", ";
+  }
+  *out << "}, \"histograms\": {";
+  separator = "";
+  for (std::map<string, Histogram>::iterator it = r.histograms.begin();
+       it != r.histograms.end(); ++it) {
+    const Histogram &h = it->second;
+    *out << separator << "\"" << it->first << "\": {\"count\": " << h.count
+         << ", \"sum\": " << h.sum << ", \"min\": "
+         << (h.count == 0 ? 0 : h.min.load()) << ", \"max\": " << h.max
+         << ", \"buckets\": [";
+    const char *bucket_separator = "";
+    for (int i = 0; i < N_BUCKETS; ++i) {
+      if (h.buckets[i] == 0) continue;
+      *out << bucket_separator << "["
+           << (i == 0 ? 0 : static_cast<uint64_t>(1) << (i - 1)) << ", "
+           << h.buckets[i] << "]";
+      bucket_separator = ", ";
+    }
+    *out << "]}";
+    separator = ", ";
+  }
+  *out << "}}" << std::endl;
+}
+
+// Whether statistics were compiled in.
+bool Stats::is_enabled() {
+#ifdef FA_ENABLE_STATS
+  return true;
+#else
+  return false;
+#endif
+}
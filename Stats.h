@@ -0,0 +1,236 @@
+//
+// Stats.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+using std::string;
+
+/**
+ Opt-in statistics: counters, phase timers and histograms keyed by name.
+
+ The hot paths are instrumented using the FA_STATS_* macros, which compile to
+ nothing unless FA_ENABLE_STATS is defined (e.g. -DFA_ENABLE_STATS). Each
+ macro looks its statistic up once (a function-local static) and then only
+ does relaxed atomic updates, so instrumented code may run on many threads.
+ With FA_ENABLE_STATS, allocations are also counted by replacing the global
+ operator new, see FA_STATS_ALLOCATIONS.
+
+ Statistics are read using the getters below or dumped as JSON, on one line:
+
+     {"counters": {"name": 1, ...},
+      "timers": {"name": {"count": 1, "seconds": 0.5}, ...},
+      "histograms": {"name": {"count": 2, "sum": 5, "min": 1, "max": 4,
+                              "buckets": [[1, 1], [4, 1]]}, ...}}
+
+ A histogram bucket [b, n] holds the n values v with b <= v < 2b (b is zero
+ or a power of two).
+ */
+class Stats {
+ public:
+  // Total buckets of a histogram: zero, then one per power of two
+  static const int N_BUCKETS = 65;
+
+  /**
+   Monotonic counter.
+   */
+  struct Counter {
+    std::atomic<uint64_t> value;
+    void add(uint64_t n) { value.fetch_add(n, std::memory_order_relaxed); }
+  };
+
+  /**
+   Total time spent in a phase and the times it was entered.
+   */
+  struct Timer {
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> nanoseconds;
+    void add(uint64_t ns) {
+      count.fetch_add(1, std::memory_order_relaxed);
+      nanoseconds.fetch_add(ns, std::memory_order_relaxed);
+    }
+  };
+
+  /**
+   Distribution of values in power of two buckets.
+   */
+  struct Histogram {
+    std::atomic<uint64_t> buckets[N_BUCKETS];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> min;
+    std::atomic<uint64_t> max;
+    void add(uint64_t value);
+  };
+
+  /**
+   Times a scope and adds it to a timer.
+   */
+  class ScopedTimer {
+   public:
+    explicit ScopedTimer(Timer *timer)
+        : timer(timer), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+      timer->add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start).count());
+    }
+
+   private:
+    // Timer to add to
+    Timer *timer;
+
+    // Start of the scope
+    std::chrono::steady_clock::time_point start;
+  };
+
+  /**
+   Counts the allocations made by this thread in a scope and adds the count to
+   a histogram.
+   */
+  class ScopedAllocations {
+   public:
+    explicit ScopedAllocations(Histogram *histogram)
+        : histogram(histogram), start(get_thread_allocations()) {}
+    ~ScopedAllocations() {
+      histogram->add(get_thread_allocations() - start);
+    }
+
+   private:
+    // Histogram to add to
+    Histogram *histogram;
+
+    // Allocations of this thread at the start of the scope
+    uint64_t start;
+  };
+
+  /**
+   Get a counter, creating it if needed. The pointer stays valid.
+   @param name Name of the counter
+   @return Counter
+   */
+  static Counter *counter(const string &name);
+
+  /**
+   Get a timer, creating it if needed. The pointer stays valid.
+   @param name Name of the timer
+   @return Timer
+   */
+  static Timer *timer(const string &name);
+
+  /**
+   Get a histogram, creating it if needed. The pointer stays valid.
+   @param name Name of the histogram
+   @return Histogram
+   */
+  static Histogram *histogram(const string &name);
+
+  /**
+   Get the value of a counter.
+   @param name Name of the counter
+   @return Value, zero if there is no such counter
+   */
+  static uint64_t get_counter(const string &name);
+
+  /**
+   Get the total time of a timer.
+   @param name Name of the timer
+   @return Seconds, zero if there is no such timer
+   */
+  static double get_timer(const string &name);
+
+  /**
+   Get the times a timer was entered.
+   @param name Name of the timer
+   @return Count, zero if there is no such timer
+   */
+  static uint64_t get_timer_count(const string &name);
+
+  /**
+   Get total values added to a histogram.
+   @param name Name of the histogram
+   @return Count, zero if there is no such histogram
+   */
+  static uint64_t get_histogram_count(const string &name);
+
+  /**
+   Get the mean of a histogram.
+   @param name Name of the histogram
+   @return Mean, zero if there is no such histogram or it is empty
+   */
+  static double get_histogram_mean(const string &name);
+
+  /**
+   Get allocations made by this thread so far.
+   @return Allocations, always zero unless FA_ENABLE_STATS is defined
+   */
+  static uint64_t get_thread_allocations();
+
+  /**
+   Set every statistic to zero.
+   */
+  static void reset();
+
+  /**
+   Output every statistic as JSON on one line.
+   @param out Stream to write to
+   */
+  static void dump_json(std::ostream *out);
+
+  /**
+   Whether statistics were compiled in, i.e. FA_ENABLE_STATS is defined.
+   @return True if enabled, false otherwise
+   */
+  static bool is_enabled();
+};
+
+#ifdef FA_ENABLE_STATS
+
+#define FA_STATS_CONCAT_(a, b) a##b
+#define FA_STATS_CONCAT(a, b) FA_STATS_CONCAT_(a, b)
+
+// Add n to a counter
+#define FA_STATS_COUNT(name, n) do { \
+    static Stats::Counter *fa_stats_counter = Stats::counter(name); \
+    fa_stats_counter->add(n); \
+  } while (0)
+
+// Add a value to a histogram
+#define FA_STATS_RECORD(name, value) do { \
+    static Stats::Histogram *fa_stats_histogram = Stats::histogram(name); \
+    fa_stats_histogram->add(value); \
+  } while (0)
+
+// Add the time until the end of the enclosing scope to a timer
+#define FA_STATS_TIMER(name) \
+  static Stats::Timer *FA_STATS_CONCAT(fa_stats_timer_, __LINE__) = \
+      Stats::timer(name); \
+  Stats::ScopedTimer FA_STATS_CONCAT(fa_stats_scope_, __LINE__)( \
+      FA_STATS_CONCAT(fa_stats_timer_, __LINE__))
+
+// Add the allocations until the end of the enclosing scope to a histogram
+#define FA_STATS_ALLOCATIONS(name) \
+  static Stats::Histogram *FA_STATS_CONCAT(fa_stats_allocs_, __LINE__) = \
+      Stats::histogram(name); \
+  Stats::ScopedAllocations FA_STATS_CONCAT(fa_stats_scope_, __LINE__)( \
+      FA_STATS_CONCAT(fa_stats_allocs_, __LINE__))
+
+#else
+
+#define FA_STATS_COUNT(name, n) do {} while (0)
+#define FA_STATS_RECORD(name, value) do {} while (0)
+#define FA_STATS_TIMER(name)
+#define FA_STATS_ALLOCATIONS(name)
+
+#endif  // FA_ENABLE_STATS
+
+#endif  // STATS_H_
@@ -0,0 +1,246 @@
+//
+// SymbolicNFA.cpp
+// FiniteAutomataLabExperiments
+//
+
+#include "./SymbolicNFA.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "./Stats.h"
+
+using std::map;
+using std::vector;
+
+// Init MAX_CODE_POINT
+const uint32_t SymbolicNFA::MAX_CODE_POINT;
+
+// Constructor.
+SymbolicNFA::SymbolicNFA(int n_states, const vector<state> &start_states,
+                         const vector<state> &accepting_states)
+    : accepting_states(accepting_states), epsilon_transitions(n_states),
+      start_states(start_states), transitions(n_states) {}
+
+// Add a new non-accepting state.
+state SymbolicNFA::add_state() {
+  transitions.push_back(vector<Edge>());
+  epsilon_transitions.push_back(vector<state>());
+  return transitions.size() - 1;
+}
+
+// Insert a transition on a set of bytes.
+void SymbolicNFA::set_state(state q, const ByteSet &set, state s) {
+  if (set.empty()) return;
+  Edge edge = { find_label(set), s };
+  transitions[q].push_back(edge);
+}
+
+// Insert an epsilon transition.
+void SymbolicNFA::set_epsilon(state q, state s) {
+  epsilon_transitions[q].push_back(s);
+}
+
+// Insert transitions on the UTF-8 encodings of a range of code points.
+bool SymbolicNFA::set_code_points(state q, uint32_t first, uint32_t last,
+                                  state s) {
+  if (first > last || last > MAX_CODE_POINT) return false;
+  // Skip the surrogates
+  if (first <= 0xDFFF && last >= 0xD800) {
+    if (first < 0xD800) set_code_points(q, first, 0xD7FF, s);
+    if (last > 0xDFFF) set_code_points(q, 0xE000, last, s);
+    return true;
+  }
+  // Split where the length of the encoding changes
+  static const uint32_t LENGTH_ENDS[3] = { 0x7F, 0x7FF, 0xFFFF };
+  for (int i = 0; i < 3; ++i) {
+    if (first <= LENGTH_ENDS[i] && last > LENGTH_ENDS[i]) {
+      set_code_points(q, first, LENGTH_ENDS[i], s);
+      set_code_points(q, LENGTH_ENDS[i] + 1, last, s);
+      return true;
+    }
+  }
+  set_utf8_sequence(q, first, last, s);
+  return true;
+}
+
+// Insert transitions on a range of code points whose UTF-8 encodings all have
+// the same length.
+void SymbolicNFA::set_utf8_sequence(state q, uint32_t first, uint32_t last,
+                                    state s) {
+  if (last <= 0x7F) {
+    set_range(q, first, last, s);
+    return;
+  }
+  // Split until every byte of the encodings ranges independently of the
+  // others, i.e. a byte may only span its whole range (0x80 to 0xBF) if every
+  // byte after it does
+  for (int i = 1; i < 4; ++i) {
+    uint32_t m = (static_cast<uint32_t>(1) << (6 * i)) - 1;
+    if ((first & ~m) == (last & ~m)) continue;
+    if ((first & m) != 0) {
+      set_utf8_sequence(q, first, first | m, s);
+      set_utf8_sequence(q, (first | m) + 1, last, s);
+      return;
+    }
+    if ((last & m) != m) {
+      set_utf8_sequence(q, first, (last & ~m) - 1, s);
+      set_utf8_sequence(q, last & ~m, last, s);
+      return;
+    }
+  }
+  unsigned char low[4], high[4];
+  int n = encode_utf8(first, low);
+  encode_utf8(last, high);
+  for (int i = 0; i + 1 < n; ++i) {
+    state p = add_state();
+    set_range(q, low[i], high[i], p);
+    q = p;
+  }
+  set_range(q, low[n - 1], high[n - 1], s);
+}
+
+// UTF-8 encoding of a code point.
+int SymbolicNFA::encode_utf8(uint32_t c, unsigned char bytes[4]) {
+  if (c <= 0x7F) {
+    bytes[0] = c;
+    return 1;
+  }
+  if (c <= 0x7FF) {
+    bytes[0] = 0xC0 | (c >> 6);
+    bytes[1] = 0x80 | (c & 0x3F);
+    return 2;
+  }
+  if (c <= 0xFFFF) {
+    bytes[0] = 0xE0 | (c >> 12);
+    bytes[1] = 0x80 | ((c >> 6) & 0x3F);
+    bytes[2] = 0x80 | (c & 0x3F);
+    return 3;
+  }
+  bytes[0] = 0xF0 | (c >> 18);
+  bytes[1] = 0x80 | ((c >> 12) & 0x3F);
+  bytes[2] = 0x80 | ((c >> 6) & 0x3F);
+  bytes[3] = 0x80 | (c & 0x3F);
+  return 4;
+}
+
+// Get the index of a label, adding it if new.
+int SymbolicNFA::find_label(const ByteSet &set) {
+  std::pair<map<ByteSet, int>::iterator, bool> found =
+      label_index.insert(std::make_pair(set, labels.size()));
+  if (found.second) labels.push_back(set);
+  return found.first->second;
+}
+
+// Partition the bytes into minterms.
+int SymbolicNFA::find_minterms(state classes[256]) const {
+  std::fill(classes, classes + 256, 0);
+  int n_classes = 1;
+  // Every label splits each class into the bytes it has and those it has not,
+  // classes are numbered again in the order of their first byte
+  vector<int> split;
+  for (int l = 0; l < labels.size(); ++l) {
+    split.assign(2 * n_classes, -1);
+    int n_split = 0;
+    for (int e = 0; e < 256; ++e) {
+      int &c = split[2 * classes[e] + labels[l].contains(e)];
+      if (c < 0) c = n_split++;
+      classes[e] = c;
+    }
+    n_classes = n_split;
+    if (n_classes == 256) break;
+  }
+  return n_classes;
+}
+
+// Determinize using subset construction over the minterms.
+CompiledDFA SymbolicNFA::to_CompiledDFA() const {
+  FA_STATS_TIMER("symbolic_nfa.to_compiled_dfa");
+  state classes[256];
+  int n_classes = find_minterms(classes);
+  FA_STATS_RECORD("symbolic_nfa.minterms", n_classes);
+  // Any byte of a class stands for the whole class
+  vector<int> representatives(n_classes, -1);
+  for (int e = 255; e >= 0; --e) representatives[classes[e]] = e;
+  vector< vector<int> > label_classes(labels.size());
+  for (int l = 0; l < labels.size(); ++l)
+    for (int c = 0; c < n_classes; ++c)
+      if (labels[l].contains(representatives[c])) label_classes[l].push_back(c);
+  int n_states = get_n_states();
+  vector<bool> is_accepting(n_states, false);
+  for (int i = 0; i < accepting_states.size(); ++i)
+    is_accepting[accepting_states[i]] = true;
+
+  vector<unsigned int> marks(n_states, 0);
+  unsigned int mark = 0;
+  // Subsets double as the worklist, every subset from `i` onwards is yet to
+  // be explored
+  vector< vector<state> > subsets(1, start_states);
+  close(&subsets[0], &marks, &mark);
+  std::unordered_map<vector<state>, state, StatesHash> subset_index;
+  subset_index.insert(std::make_pair(subsets[0], 0));
+  vector<state> table;
+  vector<bool> accepting;
+  vector< vector<state> > next(n_classes);
+  for (int i = 0; i < subsets.size(); ++i) {
+    bool accepts = false;
+    for (int c = 0; c < n_classes; ++c) next[c].clear();
+    for (int k = 0; k < subsets[i].size(); ++k) {
+      state q = subsets[i][k];
+      accepts = accepts || is_accepting[q];
+      for (int j = 0; j < transitions[q].size(); ++j) {
+        const vector<int> &to_classes = label_classes[transitions[q][j].label];
+        for (int c = 0; c < to_classes.size(); ++c)
+          next[to_classes[c]].push_back(transitions[q][j].to);
+      }
+    }
+    accepting.push_back(accepts);
+    for (int c = 0; c < n_classes; ++c) {
+      if (next[c].empty()) {
+        table.push_back(DFA::NO_STATE);
+        continue;
+      }
+      close(&next[c], &marks, &mark);
+      std::pair<std::unordered_map<vector<state>, state,
+                                   StatesHash>::iterator, bool> found =
+          subset_index.insert(std::make_pair(next[c], subsets.size()));
+      if (found.second) subsets.push_back(next[c]);
+      table.push_back(found.first->second);
+    }
+  }
+  FA_STATS_COUNT("symbolic_nfa.subsets", subsets.size());
+  return CompiledDFA(classes, n_classes, subsets.size(), table, 0, accepting);
+}
+
+// Sort a set of states, remove duplicates and add the e-closures.
+void SymbolicNFA::close(vector<state> *states, vector<unsigned int> *marks,
+                        unsigned int *mark) const {
+  if (++*mark == 0) {
+    std::fill(marks->begin(), marks->end(), 0);
+    *mark = 1;
+  }
+  // The set doubles as the queue of a breadth-first search, marks prevent
+  // visiting a state twice
+  size_t n = 0;
+  for (size_t i = 0; i < states->size(); ++i) {
+    state p = (*states)[i];
+    if ((*marks)[p] != *mark) {
+      (*marks)[p] = *mark;
+      (*states)[n++] = p;
+    }
+  }
+  states->resize(n);
+  for (size_t i = 0; i < states->size(); ++i) {
+    const vector<state> &e_states = epsilon_transitions[(*states)[i]];
+    for (int k = 0; k < e_states.size(); ++k) {
+      if ((*marks)[e_states[k]] != *mark) {
+        (*marks)[e_states[k]] = *mark;
+        states->push_back(e_states[k]);
+      }
+    }
+  }
+  std::sort(states->begin(), states->end());
+}
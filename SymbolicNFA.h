@@ -0,0 +1,272 @@
+//
+// SymbolicNFA.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef SYMBOLIC_NFA_H_
+#define SYMBOLIC_NFA_H_
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include "./CompiledDFA.h"
+#include "./NFA_to_DFA.h"
+#include "./StateCache.h"
+
+using std::map;
+using std::vector;
+
+/**
+ Set of bytes, i.e. a label of a symbolic transition.
+ */
+class ByteSet {
+ public:
+  /**
+   Constructor, the set is empty.
+   */
+  ByteSet() { bits[0] = bits[1] = bits[2] = bits[3] = 0; }
+
+  /**
+   Constructor, a range of bytes.
+   @param first First byte
+   @param last Last byte, inclusive
+   */
+  ByteSet(unsigned char first, unsigned char last) : ByteSet() {
+    add(first, last);
+  }
+
+  /**
+   Set of all the 256 bytes.
+   @return Set
+   */
+  static ByteSet all() { return ByteSet(0, 255); }
+
+  /**
+   Add a byte.
+   @param e Byte to add
+   */
+  void add(unsigned char e) {
+    bits[e >> 6] |= static_cast<uint64_t>(1) << (e & 63);
+  }
+
+  /**
+   Add a range of bytes.
+   @param first First byte
+   @param last Last byte, inclusive
+   */
+  void add(unsigned char first, unsigned char last) {
+    for (int e = first; e <= last; ++e) add(static_cast<unsigned char>(e));
+  }
+
+  /**
+   Whether the set has the given byte.
+   @param e Byte to check for
+   @return True if the set has the byte, false otherwise
+   */
+  bool contains(unsigned char e) const {
+    return (bits[e >> 6] >> (e & 63)) & 1;
+  }
+
+  /**
+   Whether the set is empty.
+   @return True if empty, false otherwise
+   */
+  bool empty() const { return (bits[0] | bits[1] | bits[2] | bits[3]) == 0; }
+
+  /**
+   Get the bytes not in the set.
+   @return Complement of the set
+   */
+  ByteSet complement() const {
+    ByteSet set;
+    for (int i = 0; i < 4; ++i) set.bits[i] = ~bits[i];
+    return set;
+  }
+
+  /**
+   Whether both sets have the same bytes.
+   @param other Set to compare with
+   @return True if equal, false otherwise
+   */
+  bool operator==(const ByteSet &other) const {
+    for (int i = 0; i < 4; ++i)
+      if (bits[i] != other.bits[i]) return false;
+    return true;
+  }
+
+  /**
+   Arbitrary total order, for ordered containers.
+   @param other Set to compare with
+   @return True if this set comes first, false otherwise
+   */
+  bool operator<(const ByteSet &other) const {
+    for (int i = 0; i < 4; ++i)
+      if (bits[i] != other.bits[i]) return bits[i] < other.bits[i];
+    return false;
+  }
+
+ private:
+  // Bit e is set if byte e is in the set
+  uint64_t bits[4];
+};
+
+/**
+ NFA whose transitions are labeled with sets of bytes instead of single input
+ symbols, so the alphabet is always every byte and a transition on a range
+ such as `[a-z]` or on any byte is a single edge. Code point ranges are
+ compiled to sequences of byte ranges accepting their UTF-8 encodings.
+
+ Determinization never loops over the alphabet: the bytes are first
+ partitioned into minterms, i.e. the classes of bytes which no label tells
+ apart, and subsets are explored once per class. The DFA is a CompiledDFA
+ over these classes, so both the work and the table width grow with the
+ number of distinct behaviors, not with the alphabet size.
+ */
+class SymbolicNFA {
+ public:
+  // Largest Unicode code point
+  static const uint32_t MAX_CODE_POINT = 0x10FFFF;
+
+  /**
+   Constructor.
+   @param n_states Total states
+   @param start_states Start states
+   @param accepting_states Accepting states
+   */
+  SymbolicNFA(int n_states, const vector<state> &start_states,
+              const vector<state> &accepting_states);
+
+  /**
+   Add a new non-accepting state.
+   @return New state
+   */
+  state add_state();
+
+  /**
+   Insert a transition on a set of bytes.
+   @param q Current state
+   @param set Bytes of the transition, nothing is inserted if empty
+   @param s Destination state
+   */
+  void set_state(state q, const ByteSet &set, state s);
+
+  /**
+   Insert a transition on a range of bytes.
+   @param q Current state
+   @param first First byte
+   @param last Last byte, inclusive
+   @param s Destination state
+   */
+  void set_range(state q, unsigned char first, unsigned char last, state s) {
+    set_state(q, ByteSet(first, last), s);
+  }
+
+  /**
+   Insert an epsilon transition.
+   @param q Current state
+   @param s Destination state
+   */
+  void set_epsilon(state q, state s);
+
+  /**
+   Insert transitions on the UTF-8 encodings of a range of code points, which
+   may add intermediate states. Surrogates (U+D800 to U+DFFF) have no UTF-8
+   encoding and are skipped.
+   @param q Current state
+   @param first First code point
+   @param last Last code point, inclusive
+   @param s Destination state
+   @return True on success, false if the range is empty or goes beyond
+           MAX_CODE_POINT
+   */
+  bool set_code_points(state q, uint32_t first, uint32_t last, state s);
+
+  /**
+   Get total states.
+   @return Total states
+   */
+  int get_n_states() const { return transitions.size(); }
+
+  /**
+   Partition the bytes into minterms: two bytes are in the same class if and
+   only if every transition has both or neither of them.
+   @param classes Output: class of each of the 256 bytes, numbered in the
+                  order of their first byte
+   @return Total classes
+   */
+  int find_minterms(state classes[256]) const;
+
+  /**
+   Determinize using subset construction over the minterms.
+   @return Compiled DFA, missing transitions lead to its dead state
+   */
+  CompiledDFA to_CompiledDFA() const;
+
+ private:
+  /**
+   A transition on a set of bytes.
+   */
+  struct Edge {
+    // Index of the label in labels
+    int label;
+    // Destination state
+    state to;
+  };
+
+  // Accepting states
+  vector<state> accepting_states;
+
+  // Epsilon transitions of each state
+  vector< vector<state> > epsilon_transitions;
+
+  // Index of each label in labels
+  map<ByteSet, int> label_index;
+
+  // Distinct labels of all transitions
+  vector<ByteSet> labels;
+
+  // Start states
+  vector<state> start_states;
+
+  // Transitions of each state, without the epsilon transitions
+  vector< vector<Edge> > transitions;
+
+  /**
+   Get the index of a label, adding it if new.
+   @param set Label
+   @return Index of labels
+   */
+  int find_label(const ByteSet &set);
+
+  /**
+   Insert transitions on a range of code points whose UTF-8 encodings all
+   have the same length.
+   @param q Current state
+   @param first First code point
+   @param last Last code point
+   @param s Destination state
+   */
+  void set_utf8_sequence(state q, uint32_t first, uint32_t last, state s);
+
+  /**
+   Sort a set of states, remove duplicates and add the e-closures.
+   @param states Set of states, replaced by the result
+   @param marks Per state marks
+   @param mark Current mark, moved to the next one
+   */
+  void close(vector<state> *states, vector<unsigned int> *marks,
+             unsigned int *mark) const;
+
+  /**
+   UTF-8 encoding of a code point.
+   @param c Code point, not a surrogate
+   @param bytes Output: 1 to 4 bytes
+   @return Total bytes
+   */
+  static int encode_utf8(uint32_t c, unsigned char bytes[4]);
+};
+
+#endif  // SYMBOLIC_NFA_H_
@@ -0,0 +1,56 @@
+//
+// SymbolicNFA_example.cpp
+// FiniteAutomataLabExperiments
+//
+// Build an NFA with byte range and UTF-8 code point range transitions
+// matching words of Latin, Greek or CJK letters followed by optional digits,
+// determinize it over its minterms and match strings with it, `-1` to exit
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "CompiledDFA.h"
+#include "SymbolicNFA.h"
+
+using std::cin;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+int main() {
+  // q0 -letter-> q1 -letter-> q1 -digit-> q2 -digit-> q2, q1 and q2 accept
+  vector<state> accepting_states;
+  accepting_states.push_back(1);
+  accepting_states.push_back(2);
+  SymbolicNFA nfa(3, vector<state>(1, 0), accepting_states);
+  for (state q = 0; q < 2; ++q) {
+    ByteSet latin('A', 'Z');
+    latin.add('a', 'z');
+    nfa.set_state(q, latin, 1);
+    // Greek and Coptic, then CJK Unified Ideographs
+    nfa.set_code_points(q, 0x370, 0x3FF, 1);
+    nfa.set_code_points(q, 0x4E00, 0x9FFF, 1);
+  }
+  nfa.set_range(1, '0', '9', 2);
+  nfa.set_range(2, '0', '9', 2);
+
+  state classes[256];
+  int n_minterms = nfa.find_minterms(classes);
+  CompiledDFA dfa = nfa.to_CompiledDFA();
+  cout << "NFA: " << nfa.get_n_states() << " states (with UTF-8 states), "
+       << n_minterms << " minterms" << endl;
+  cout << "DFA: " << dfa.get_n_states() << " states (with dead state), "
+       << dfa.get_n_classes() << " symbol classes\n" << endl;
+
+  string str;
+  while (true) {
+    cout << "Enter a string: "; cin >> str;
+    if (str == "-1") break;
+    bool status = dfa.evaluate(str);
+    cout << "Status: " << (status ? "Accepted" : "Rejected") << "\n" << endl;
+  }
+  return 0;
+}
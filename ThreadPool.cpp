@@ -0,0 +1,129 @@
+//
+// ThreadPool.cpp
+// FiniteAutomataLabExperiments
+//
+
+#include "./ThreadPool.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+// Most chunks of a loop, the index of a chunk must fit in 32 bits
+static const size_t MAX_CHUNKS = static_cast<size_t>(1) << 31;
+
+// Constructor, starts the threads.
+ThreadPool::ThreadPool(int n_threads)
+    : n_threads(n_threads > 0 ? n_threads :
+                std::max<int>(1, std::thread::hardware_concurrency())),
+      queues(this->n_threads), generation(0), busy(0), stopping(false),
+      task(NULL), n_items(0), grain(1), n_steals(0) {
+  for (int t = 0; t < this->n_threads; ++t) queues[t].range = 0;
+  for (int t = 1; t < this->n_threads; ++t)
+    threads.push_back(std::thread(&ThreadPool::work, this, t));
+}
+
+// Destructor, stops the threads.
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  start.notify_all();
+  for (int i = 0; i < threads.size(); ++i) threads[i].join();
+}
+
+// Run a task on every item.
+void ThreadPool::parallel_for(size_t n_items, size_t grain,
+                              const Task &task) {
+  if (n_items == 0) return;
+  if (grain == 0) grain = 1;
+  if ((n_items + grain - 1) / grain > MAX_CHUNKS)
+    grain = (n_items + MAX_CHUNKS - 1) / MAX_CHUNKS;
+  uint64_t n_chunks = (n_items + grain - 1) / grain;
+  std::lock_guard<std::mutex> loop_lock(loop);
+  // Equal shares of the chunks, in order so that a thread's items are
+  // contiguous
+  for (int t = 0; t < n_threads; ++t) {
+    uint64_t first = n_chunks * t / n_threads;
+    uint64_t last = n_chunks * (t + 1) / n_threads;
+    queues[t].range = (first << 32) | last;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->task = &task;
+    this->n_items = n_items;
+    this->grain = grain;
+    busy = n_threads - 1;
+    ++generation;
+  }
+  start.notify_all();
+  run_chunks(0);
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait(lock, [this]() { return busy == 0; });
+}
+
+// Loop of a worker thread.
+void ThreadPool::work(int t) {
+  uint64_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      start.wait(lock, [&]() { return stopping || generation != seen; });
+      if (stopping) return;
+      seen = generation;
+    }
+    run_chunks(t);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      --busy;
+    }
+    done.notify_one();
+  }
+}
+
+// Run chunks of the current loop until every queue is empty.
+void ThreadPool::run_chunks(int t) {
+  uint32_t chunk;
+  for (int i = 0; i < n_threads; ++i) {
+    // Own queue first, from the front, then the others from the back
+    int victim = (t + i) % n_threads;
+    while (i == 0 ? pop_front(&queues[victim], &chunk) :
+                    pop_back(&queues[victim], &chunk)) {
+      if (i > 0) ++n_steals;
+      size_t first = chunk * grain;
+      (*task)(first, std::min(first + grain, n_items));
+    }
+  }
+}
+
+// Take a chunk from the front of a queue.
+bool ThreadPool::pop_front(Queue *queue, uint32_t *chunk) {
+  uint64_t range = queue->range.load();
+  while (true) {
+    uint64_t first = range >> 32, last = range & 0xFFFFFFFF;
+    if (first >= last) return false;
+    if (queue->range.compare_exchange_weak(range,
+                                           ((first + 1) << 32) | last)) {
+      *chunk = first;
+      return true;
+    }
+  }
+}
+
+// Take a chunk from the back of a queue.
+bool ThreadPool::pop_back(Queue *queue, uint32_t *chunk) {
+  uint64_t range = queue->range.load();
+  while (true) {
+    uint64_t first = range >> 32, last = range & 0xFFFFFFFF;
+    if (first >= last) return false;
+    if (queue->range.compare_exchange_weak(range,
+                                           (first << 32) | (last - 1))) {
+      *chunk = last - 1;
+      return true;
+    }
+  }
+}
@@ -0,0 +1,164 @@
+//
+// ThreadPool.h
+// FiniteAutomataLabExperiments
+//
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+/**
+ Work-stealing pool of threads running data-parallel loops.
+
+ Threads are started once and sleep between loops. A loop over n items is cut
+ into chunks of `grain` items, and each thread gets an equal share of the
+ chunks in a queue of its own. A thread takes chunks from the front of its
+ queue and, once it is empty, steals from the back of the others, so uneven
+ items (e.g. strings of very different lengths) still keep every thread busy.
+ Queues are ranges of chunk indices updated with compare-and-swap: taking a
+ chunk never locks. The thread calling parallel_for() works as one of the
+ threads. Loops run one at a time: a thread calling parallel_for() while
+ another one's loop is running waits for it to finish.
+
+ The automata are only read by the loops, so one CompiledDFA (or DFA) is
+ shared by all the threads, each keeping its current state on its own stack.
+ */
+class ThreadPool {
+ public:
+  /**
+   Task run on a range of items.
+   @param first First item
+   @param last Item after the last one
+   */
+  typedef std::function<void(size_t first, size_t last)> Task;
+
+  /**
+   Constructor, starts the threads.
+   @param n_threads Total threads including the caller, zero for the number
+                    of cores
+   */
+  explicit ThreadPool(int n_threads = 0);
+
+  /**
+   Destructor, stops the threads.
+   */
+  ~ThreadPool();
+
+  /**
+   Run a task on every item, returns when all the items are done. Calls from
+   several threads are serialized. Must not be called from a task.
+   @param n_items Total items
+   @param grain Items per chunk, at least 1
+   @param task Task run on each chunk, from any of the threads
+   */
+  void parallel_for(size_t n_items, size_t grain, const Task &task);
+
+  /**
+   Get total threads, including the one calling parallel_for().
+   @return Total threads
+   */
+  int get_n_threads() const { return n_threads; }
+
+  /**
+   Get total chunks stolen from other threads since construction.
+   @return Total steals
+   */
+  uint64_t get_n_steals() const { return n_steals; }
+
+ private:
+  /**
+   Chunks left to a thread.
+   */
+  struct Queue {
+    // Next chunk in the high 32 bits, chunk after the last one in the low 32
+    // bits
+    std::atomic<uint64_t> range;
+    // Keeps the ranges of two threads out of the same cache line
+    char padding[64 - sizeof(std::atomic<uint64_t>)];
+  };
+
+  // Total threads including the caller
+  int n_threads;
+
+  // Chunk queue of each thread, the caller's is the first
+  vector<Queue> queues;
+
+  // Worker threads, all but the caller
+  vector<std::thread> threads;
+
+  // Held by parallel_for() for a whole loop, the queues and the fields
+  // below belong to one loop at a time
+  std::mutex loop;
+
+  // Guards the fields below, only taken to start and finish a loop
+  std::mutex mutex;
+
+  // Signaled when a loop starts or the pool stops
+  std::condition_variable start;
+
+  // Signaled when a worker is done with a loop
+  std::condition_variable done;
+
+  // Incremented for every loop, tells workers a new loop is there
+  uint64_t generation;
+
+  // Workers still running the current loop
+  int busy;
+
+  // Whether the threads must exit
+  bool stopping;
+
+  // Task of the current loop
+  const Task *task;
+
+  // Items and items per chunk of the current loop
+  size_t n_items, grain;
+
+  // Chunks stolen so far
+  std::atomic<uint64_t> n_steals;
+
+  /**
+   Loop of a worker thread.
+   @param t Thread index
+   */
+  void work(int t);
+
+  /**
+   Run chunks of the current loop until every queue is empty.
+   @param t Thread index
+   */
+  void run_chunks(int t);
+
+  /**
+   Take a chunk from the front of a queue.
+   @param queue Queue
+   @param chunk Output: chunk index
+   @return True if a chunk was taken, false if the queue is empty
+   */
+  static bool pop_front(Queue *queue, uint32_t *chunk);
+
+  /**
+   Take a chunk from the back of a queue.
+   @param queue Queue
+   @param chunk Output: chunk index
+   @return True if a chunk was taken, false if the queue is empty
+   */
+  static bool pop_back(Queue *queue, uint32_t *chunk);
+
+  // Not copyable
+  ThreadPool(const ThreadPool &);
+  ThreadPool &operator=(const ThreadPool &);
+};
+
+#endif  // THREAD_POOL_H_
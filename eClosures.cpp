@@ -8,10 +8,20 @@
 
 #include "./eClosures.h"
 
+#include <stdint.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
 #include <string>
 #include <vector>
 
+#include "./Stats.h"
+
 using std::cout;
 using std::endl;
 using std::string;
@@ -20,6 +30,15 @@ using std::vector;
 // Init EPSILON
 const input_symbol ENFA::EPSILON = '\0';
 
+// Init DEFAULT_CACHE_BUDGET
+const size_t ENFA::DEFAULT_CACHE_BUDGET;
+
+// Init MAX_BITSET_STATES
+const int ENFA::MAX_BITSET_STATES;
+
+// Estimated memory used by a cached DFA state besides its set and row
+static const size_t CACHE_STATE_OVERHEAD = 96;
+
 // Constructor.
 ENFA::ENFA(int n_states, const vector<input_symbol> &input_symbols,
            state start_state, const vector<state> &accepting_states)
@@ -28,21 +47,35 @@ ENFA::ENFA(int n_states, const vector<input_symbol> &input_symbols,
            n_input_symbols(input_symbols.size()) {
   current_state.push_back(start_state);
   epsilon_loc = get_index_by_input_symbol(EPSILON);
+  engine = ENGINE_SET;
+  bit_ready = false;
+  search_ready = false;
+  cache_budget = DEFAULT_CACHE_BUDGET;
+  clear_cache();
+  cache_stats.hits = cache_stats.misses = cache_stats.flushes = 0;
+  for (int e = 0; e < 256; ++e)
+    symbol_index[e] = get_index_by_input_symbol(static_cast<input_symbol>(e));
   // Init transition table and e closure
-  while (n_states--) {
+  for (int i = 0; i < n_states; ++i) {
     vector< vector<state> > t_row(n_input_symbols);
     transition_table.push_back(t_row);
-    vector<state> s_row;
-    e_closures.push_back(s_row);
+    e_closure_index.push_back(i);
+    e_closures.push_back(vector<state>(1, i));
   }
 }
 
 // Evaluate the given string.
 bool ENFA::evaluate(const string &str) {
-    vector<state> s_state;
-    s_state.push_back(start_state);
-    bool found = true;
+    FA_STATS_TIMER("enfa.evaluate");
+    FA_STATS_ALLOCATIONS("enfa.evaluate.allocations");
+    FA_STATS_COUNT("enfa.evaluate.symbols", str.length());
+    if (engine == ENGINE_LAZY_DFA) return evaluate_lazy(str);
+    if (engine == ENGINE_BIT_PARALLEL) return evaluate_bit_parallel(str);
+    vector<state> s_state = eclose(start_state);
     for (int i = 0; i < str.length(); ++i) {
+      int index_e = symbol_index[static_cast<unsigned char>(str[i])];
+      // Input symbol outside of the alphabet
+      if (index_e < 0 || index_e == epsilon_loc) return false;
       vector<state> t_state = tf(s_state, str[i]);
       // DEBUG
       // cout << str[i] << ": ";
@@ -50,33 +83,434 @@ bool ENFA::evaluate(const string &str) {
       //   cout << t_state[j] << ", ";
       // cout << endl;
       s_state = t_state;
-      if (t_state.size() == 0) found = false;
+      FA_STATS_RECORD("enfa.evaluate.active_states", t_state.size());
+      // No state is left, nothing can be accepted anymore
+      if (t_state.size() == 0) return false;
+    }
+    // Accept only if the final subset of states has an accepting state
+    return has_accepting_state(s_state);
+}
+
+// Evaluate the given string using the lazy DFA.
+bool ENFA::evaluate_lazy(const string &str) {
+  if (cache_start < 0) cache_start = cache_state(eclose(start_state));
+  int q = cache_start;
+  for (int i = 0; i < str.length(); ++i) {
+    int index_e = symbol_index[static_cast<unsigned char>(str[i])];
+    // Input symbol outside of the alphabet
+    if (index_e < 0 || index_e == epsilon_loc) return false;
+    int next = cache_transitions[q * n_input_symbols + index_e];
+    if (next >= 0) {
+      ++cache_stats.hits;
+    } else {
+      ++cache_stats.misses;
+      vector<state> t_state = tf(cache_states[q], str[i]);
+      unsigned long long flushes = cache_stats.flushes;
+      next = cache_state(t_state);
+      // The cache may have been flushed, in which case q is gone
+      if (cache_stats.flushes == flushes)
+        cache_transitions[q * n_input_symbols + index_e] = next;
+    }
+    // No state is left, nothing can be accepted anymore
+    if (next == cache_dead) return false;
+    q = next;
+  }
+  return cache_accepting[q];
+}
+
+// Evaluate the given string using the bit parallel engine.
+bool ENFA::evaluate_bit_parallel(const string &str) {
+  if (!bit_ready) build_bit_parallel();
+  if (n_states > MAX_BITSET_STATES) return evaluate_sparse(str);
+  uint64_t *current = &bit_current[0];
+  uint64_t *next = &bit_next[0];
+  std::copy(bit_start.begin(), bit_start.end(), current);
+  for (int i = 0; i < str.length(); ++i) {
+    int index_e = symbol_index[static_cast<unsigned char>(str[i])];
+    // Input symbol outside of the alphabet
+    if (index_e < 0 || index_e == epsilon_loc) return false;
+    std::fill(next, next + bit_words, 0);
+    uint64_t any = 0;
+    for (int w = 0; w < bit_words; ++w) {
+      for (uint64_t bits = current[w]; bits != 0; bits &= bits - 1) {
+        int q = (w << 6) + __builtin_ctzll(bits);
+        const uint64_t *mask =
+            &bit_successors[(q * n_input_symbols + index_e) * bit_words];
+        int k = 0;
+#ifdef __AVX2__
+        for ( ; k + 4 <= bit_words; k += 4) {
+          __m256i n = _mm256_loadu_si256(reinterpret_cast<__m256i *>(next + k));
+          __m256i m = _mm256_loadu_si256(
+              reinterpret_cast<const __m256i *>(mask + k));
+          _mm256_storeu_si256(reinterpret_cast<__m256i *>(next + k),
+                              _mm256_or_si256(n, m));
+        }
+#endif
+        for ( ; k < bit_words; ++k) next[k] |= mask[k];
+      }
+    }
+    for (int w = 0; w < bit_words; ++w) any |= next[w];
+    // No state is left, nothing can be accepted anymore
+    if (any == 0) return false;
+    std::swap(current, next);
+  }
+  for (int w = 0; w < bit_words; ++w)
+    if (current[w] & bit_accepting[w]) return true;
+  return false;
+}
+
+// Evaluate the given string using sparse sets of states.
+bool ENFA::evaluate_sparse(const string &str) {
+  state *current = &sparse_current[0];
+  state *next = &sparse_next[0];
+  int *index = &sparse_index[0];
+  const vector<state> &start = eclose(start_state);
+  int current_size = start.size(), next_size;
+  std::copy(start.begin(), start.end(), current);
+  for (int i = 0; i < str.length(); ++i) {
+    int index_e = symbol_index[static_cast<unsigned char>(str[i])];
+    // Input symbol outside of the alphabet
+    if (index_e < 0 || index_e == epsilon_loc) return false;
+    next_size = 0;
+    for (int j = 0; j < current_size; ++j) {
+      int cell = current[j] * n_input_symbols + index_e;
+      for (int k = sparse_offsets[cell]; k < sparse_offsets[cell + 1]; ++k) {
+        state s = sparse_targets[k];
+        // Member of next iff index[s] points back at s
+        if (index[s] < next_size && next[index[s]] == s) continue;
+        index[s] = next_size;
+        next[next_size++] = s;
+      }
+    }
+    // No state is left, nothing can be accepted anymore
+    if (next_size == 0) return false;
+    std::swap(current, next);
+    current_size = next_size;
+  }
+  for (int j = 0; j < current_size; ++j)
+    if (sparse_accepting[current[j]]) return true;
+  return false;
+}
+
+// Search the given string for substrings accepted by the automaton.
+bool ENFA::search(const string &str, SearchMode mode, vector<Match> *matches) {
+  if (!search_ready) find_live_states();
+  const vector<state> &start = eclose(start_state);
+  return search_threads(str.size(), mode, n_states,
+      [&](SearchSet *set, size_t offset) {
+        for (int k = 0; k < start.size(); ++k)
+          if (search_live[start[k]]) set->add(start[k], offset);
+      },
+      [&](const SearchSet &from, size_t offset, SearchSet *to) {
+        int index_e = symbol_index[static_cast<unsigned char>(str[offset])];
+        // Input symbol outside of the alphabet
+        if (index_e < 0 || index_e == epsilon_loc) return;
+        for (int i = 0; i < from.size(); ++i) {
+          const vector<state> &targets =
+              transition_table[from.get_state(i)][index_e];
+          for (int j = 0; j < targets.size(); ++j) {
+            const vector<state> &closure = eclose(targets[j]);
+            for (int k = 0; k < closure.size(); ++k)
+              if (search_live[closure[k]])
+                to->add(closure[k], from.get_start(i));
+          }
+        }
+      },
+      [&](state q) { return search_accepting[q]; }, matches);
+}
+
+// Find the accepting states and the states which can reach one for search().
+void ENFA::find_live_states() {
+  search_accepting.assign(n_states, false);
+  for (int i = 0; i < accepting_states.size(); ++i)
+    search_accepting[accepting_states[i]] = true;
+  vector< vector<state> > reverse(n_states);
+  for (int q = 0; q < n_states; ++q)
+    for (int j = 0; j < n_input_symbols; ++j)
+      for (int k = 0; k < transition_table[q][j].size(); ++k)
+        reverse[transition_table[q][j][k]].push_back(q);
+  search_live = search_accepting;
+  vector<state> stack(accepting_states.begin(), accepting_states.end());
+  while (!stack.empty()) {
+    state q = stack.back();
+    stack.pop_back();
+    for (int i = 0; i < reverse[q].size(); ++i) {
+      if (!search_live[reverse[q][i]]) {
+        search_live[reverse[q][i]] = true;
+        stack.push_back(reverse[q][i]);
+      }
+    }
+  }
+  search_ready = true;
+}
+
+// Build the tables of the bit parallel engine.
+void ENFA::build_bit_parallel() {
+  bit_ready = true;
+  vector<bool> accepting(n_states, false);
+  for (int i = 0; i < accepting_states.size(); ++i)
+    accepting[accepting_states[i]] = true;
+  if (n_states > MAX_BITSET_STATES) {
+    // Successor lists with e-closures applied, without duplicates
+    sparse_offsets.assign(1, 0);
+    sparse_targets.clear();
+    vector<int> seen(n_states, -1);
+    for (int q = 0; q < n_states; ++q) {
+      for (int e = 0; e < n_input_symbols; ++e) {
+        int cell = q * n_input_symbols + e;
+        if (e != epsilon_loc) {
+          for (int j = 0; j < transition_table[q][e].size(); ++j) {
+            const vector<state> &closure = eclose(transition_table[q][e][j]);
+            for (int k = 0; k < closure.size(); ++k) {
+              if (seen[closure[k]] == cell) continue;
+              seen[closure[k]] = cell;
+              sparse_targets.push_back(closure[k]);
+            }
+          }
+        }
+        sparse_offsets.push_back(sparse_targets.size());
+      }
     }
-    // Reject even if found provided the final subset of states
-    // doesn't have a accepting state
-    if (found && !has_accepting_state(s_state)) found = false;
-    return found;
-}
-
-// Find e-closures starting with some state
-void ENFA::findEClosures(state i_state) {
-  if (i_state == n_states) return;
-  // Add default
-  e_closures[i_state].push_back(i_state);
-  findEStates(i_state);
-  // Find others
-  for (int j = 0; j < t_state.size(); ++j)
-    e_closures[i_state].push_back(t_state[j]);
-  t_state.clear();
-  findEClosures(i_state + 1);
-}
-
-// Find epsilon state for some state and save them to t_state
+    sparse_accepting = accepting;
+    sparse_current.assign(n_states, 0);
+    sparse_next.assign(n_states, 0);
+    sparse_index.assign(n_states, 0);
+    return;
+  }
+  bit_words = (n_states + 63) / 64;
+  bit_successors.assign(n_states * n_input_symbols * bit_words, 0);
+  for (int q = 0; q < n_states; ++q) {
+    for (int e = 0; e < n_input_symbols; ++e) {
+      if (e == epsilon_loc) continue;
+      uint64_t *mask = &bit_successors[(q * n_input_symbols + e) * bit_words];
+      for (int j = 0; j < transition_table[q][e].size(); ++j) {
+        const vector<state> &closure = eclose(transition_table[q][e][j]);
+        for (int k = 0; k < closure.size(); ++k)
+          mask[closure[k] >> 6] |=
+              static_cast<uint64_t>(1) << (closure[k] & 63);
+      }
+    }
+  }
+  bit_accepting.assign(bit_words, 0);
+  for (int q = 0; q < n_states; ++q)
+    if (accepting[q])
+      bit_accepting[q >> 6] |= static_cast<uint64_t>(1) << (q & 63);
+  bit_start.assign(bit_words, 0);
+  const vector<state> &start = eclose(start_state);
+  for (int i = 0; i < start.size(); ++i)
+    bit_start[start[i] >> 6] |= static_cast<uint64_t>(1) << (start[i] & 63);
+  bit_current.assign(bit_words, 0);
+  bit_next.assign(bit_words, 0);
+}
+
+// Get the cached DFA state of a set of states, adding it if not cached.
+int ENFA::cache_state(const vector<state> &states) {
+  std::unordered_map<vector<state>, int, StatesHash>::iterator it =
+      cache_index.find(states);
+  if (it != cache_index.end()) return it->second;
+  // The set is stored twice: as a key and in cache_states
+  size_t bytes = CACHE_STATE_OVERHEAD + 2 * states.size() * sizeof(state) +
+                 n_input_symbols * sizeof(int);
+  if (cache_stats.bytes + bytes > cache_budget && cache_stats.states > 0) {
+    clear_cache();
+    ++cache_stats.flushes;
+  }
+  FA_STATS_RECORD("enfa.lazy_dfa.cached_set_size", states.size());
+  int q = cache_states.size();
+  cache_index[states] = q;
+  cache_states.push_back(states);
+  cache_accepting.push_back(has_accepting_state(states));
+  // The empty set only leads to itself
+  if (states.empty()) cache_dead = q;
+  cache_transitions.resize(cache_transitions.size() + n_input_symbols,
+                           states.empty() ? q : -1);
+  ++cache_stats.states;
+  cache_stats.bytes += bytes;
+  return q;
+}
+
+// Flush the lazy DFA cache.
+void ENFA::clear_cache() {
+  cache_transitions.clear();
+  cache_states.clear();
+  cache_accepting.clear();
+  cache_index.clear();
+  cache_start = -1;
+  cache_dead = -1;
+  cache_stats.states = 0;
+  cache_stats.bytes = 0;
+}
+
+// Find e-closures of all states at once.
+void ENFA::findEClosures() {
+  FA_STATS_TIMER("enfa.find_e_closures");
+  // Cached DFA states and bit parallel tables depend on the e-closures
+  clear_cache();
+  bit_ready = false;
+  e_closures.clear();
+  e_closure_index.assign(n_states, -1);
+  if (epsilon_loc < 0) {
+    // No epsilon transitions: every state is its own e-closure
+    for (int q = 0; q < n_states; ++q) {
+      e_closure_index[q] = q;
+      e_closures.push_back(vector<state>(1, q));
+    }
+    return;
+  }
+  // Tarjan's algorithm without recursion: a frame is a state and the index
+  // of its next epsilon transition
+  vector<int> order(n_states, -1), low(n_states, 0);
+  vector<bool> on_stack(n_states, false);
+  vector<state> stack;
+  vector< std::pair<state, int> > frames;
+  // Marks for merging e-closures without duplicates: last component a state
+  // or a component was merged into
+  vector<int> marks(n_states, -1), merged(n_states, -1);
+  int counter = 0;
+  for (int root = 0; root < n_states; ++root) {
+    if (order[root] >= 0) continue;
+    frames.push_back(std::make_pair(root, 0));
+    order[root] = low[root] = counter++;
+    stack.push_back(root);
+    on_stack[root] = true;
+    while (!frames.empty()) {
+      state q = frames.back().first;
+      const vector<state> &e_states = transition_table[q][epsilon_loc];
+      int &next = frames.back().second;
+      if (next < e_states.size()) {
+        state s = e_states[next++];
+        if (order[s] < 0) {
+          order[s] = low[s] = counter++;
+          stack.push_back(s);
+          on_stack[s] = true;
+          frames.push_back(std::make_pair(s, 0));
+        } else if (on_stack[s]) {
+          low[q] = std::min(low[q], order[s]);
+        }
+        continue;
+      }
+      frames.pop_back();
+      if (!frames.empty()) {
+        state parent = frames.back().first;
+        low[parent] = std::min(low[parent], low[q]);
+      }
+      if (low[q] != order[q]) continue;
+      // q is the root of a component, whose successors are all done
+      int c = e_closures.size();
+      e_closures.push_back(vector<state>());
+      vector<state> &closure = e_closures.back();
+      size_t first = stack.size();
+      do {
+        --first;
+        on_stack[stack[first]] = false;
+        e_closure_index[stack[first]] = c;
+        marks[stack[first]] = c;
+        closure.push_back(stack[first]);
+      } while (stack[first] != q);
+      for (size_t i = first; i < stack.size(); ++i) {
+        const vector<state> &e_states = transition_table[stack[i]][epsilon_loc];
+        for (int j = 0; j < e_states.size(); ++j) {
+          int d = e_closure_index[e_states[j]];
+          if (d == c || merged[d] == c) continue;
+          merged[d] = c;
+          const vector<state> &other = e_closures[d];
+          for (int k = 0; k < other.size(); ++k) {
+            if (marks[other[k]] != c) {
+              marks[other[k]] = c;
+              closure.push_back(other[k]);
+            }
+          }
+        }
+      }
+      FA_STATS_RECORD("enfa.component_size", stack.size() - first);
+      FA_STATS_RECORD("enfa.closure_size", closure.size());
+      stack.resize(first);
+      std::sort(closure.begin(), closure.end());
+    }
+  }
+}
+
+// Remove epsilon transitions.
+ENFA ENFA::remove_epsilon() {
+  findEClosures();
+  vector<input_symbol> new_input_symbols;
+  vector<int> symbol_map;
+  for (int e = 0; e < n_input_symbols; ++e) {
+    if (e == epsilon_loc) continue;
+    new_input_symbols.push_back(input_symbols[e]);
+    symbol_map.push_back(e);
+  }
+  int new_n_input_symbols = new_input_symbols.size();
+  vector<bool> accepting(n_states, false);
+  for (int i = 0; i < accepting_states.size(); ++i)
+    accepting[accepting_states[i]] = true;
+  // Breadth-first from the start state, new state i is order[i]
+  vector<int> number(n_states, -1);
+  vector<state> order(1, start_state);
+  number[start_state] = 0;
+  // Transitions of new states, in terms of old states
+  vector< vector<state> > rows;
+  vector<int> marks(n_states, -1);
+  for (int i = 0; i < order.size(); ++i) {
+    const vector<state> &closure = eclose(order[i]);
+    for (int e = 0; e < new_n_input_symbols; ++e) {
+      int mark = i * new_n_input_symbols + e;
+      rows.push_back(vector<state>());
+      vector<state> &row = rows.back();
+      for (int k = 0; k < closure.size(); ++k) {
+        const vector<state> &targets =
+            transition_table[closure[k]][symbol_map[e]];
+        for (int j = 0; j < targets.size(); ++j) {
+          if (marks[targets[j]] == mark) continue;
+          marks[targets[j]] = mark;
+          row.push_back(targets[j]);
+          if (number[targets[j]] < 0) {
+            number[targets[j]] = order.size();
+            order.push_back(targets[j]);
+          }
+        }
+      }
+    }
+  }
+  vector<state> new_accepting_states;
+  for (int i = 0; i < order.size(); ++i) {
+    const vector<state> &closure = eclose(order[i]);
+    for (int k = 0; k < closure.size(); ++k) {
+      if (accepting[closure[k]]) {
+        new_accepting_states.push_back(i);
+        break;
+      }
+    }
+  }
+  ENFA enfa(order.size(), new_input_symbols, 0, new_accepting_states);
+  for (int i = 0; i < order.size(); ++i) {
+    for (int e = 0; e < new_n_input_symbols; ++e) {
+      const vector<state> &row = rows[i * new_n_input_symbols + e];
+      vector<state> &cell = enfa.transition_table[i][e];
+      cell.reserve(row.size());
+      for (int j = 0; j < row.size(); ++j) cell.push_back(number[row[j]]);
+    }
+  }
+  enfa.findEClosures();
+  return enfa;
+}
+
+// Find states reachable from some state using one or more epsilon
+// transitions and save them to t_state
 void ENFA::findEStates(state i_state) {
-  vector<state> e_states = transition_table[i_state][epsilon_loc];
-  for (int i = 0; i < e_states.size(); ++i) {
-    t_state.push_back(e_states[i]);
-    findEStates(e_states[i]);
+  if (epsilon_loc < 0) return;
+  vector<bool> seen(n_states, false);
+  vector<state> stack(1, i_state);
+  while (!stack.empty()) {
+    state q = stack.back();
+    stack.pop_back();
+    const vector<state> &e_states = transition_table[q][epsilon_loc];
+    for (int i = 0; i < e_states.size(); ++i) {
+      if (seen[e_states[i]]) continue;
+      seen[e_states[i]] = true;
+      t_state.push_back(e_states[i]);
+      stack.push_back(e_states[i]);
+    }
   }
 }
 
@@ -106,10 +540,11 @@ bool ENFA::is_accepting_state(state q) {
 
 // Print all e-closures
 void ENFA::printEClosures() {
-  for (int i = 0; i < e_closures.size(); ++i) {
-    cout << "ECLOSE(" << 'q' << e_closures[i][0] << ") = { ";
-    for (int q = 0; q < e_closures[i].size(); ++q) {
-      cout << 'q' << e_closures[i][q] << ", ";
+  for (int i = 0; i < n_states; ++i) {
+    const vector<state> &closure = eclose(i);
+    cout << "ECLOSE(" << 'q' << i << ") = { ";
+    for (int q = 0; q < closure.size(); ++q) {
+      cout << 'q' << closure[q] << ", ";
     }
     cout << "}" << endl;
   }
@@ -117,9 +552,23 @@ void ENFA::printEClosures() {
 
 // Insert data into transition table.
 void ENFA::set_state(state q, input_symbol e, state s) {
+  clear_cache();
+  bit_ready = false;
+  search_ready = false;
   transition_table[q][get_index_by_input_symbol(e)].push_back(s);
 }
 
+// Insert many destination states at once, allocating only once.
+void ENFA::set_states(state q, input_symbol e, const state *first,
+                      const state *last) {
+  clear_cache();
+  bit_ready = false;
+  search_ready = false;
+  vector<state> &cell = transition_table[q][get_index_by_input_symbol(e)];
+  cell.reserve(cell.size() + (last - first));
+  cell.insert(cell.end(), first, last);
+}
+
 // Transition function.
 vector<state> ENFA::tf(const vector<state> &q, input_symbol e) {
   vector<bool> tmp_state(n_states, false);
@@ -129,8 +578,8 @@ vector<state> ENFA::tf(const vector<state> &q, input_symbol e) {
   for (s = q.begin(); s != q.end(); ++s) {
     // Add states
     for (int j = 0; j < transition_table[*s][index_input_sym].size(); ++j) {
-      vector<state> states =
-          e_closures[transition_table[*s][index_input_sym][j]];
+      const vector<state> &states =
+          eclose(transition_table[*s][index_input_sym][j]);
       for (int i = 0; i < states.size(); ++i)
         tmp_state[states[i]] = true;
     }
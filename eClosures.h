@@ -9,9 +9,16 @@
 #ifndef ECLOSURES_H_
 #define ECLOSURES_H_
 
+#include <stdint.h>
+
+#include <cstddef>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "./Search.h"
+#include "./StateCache.h"
+
 // Define types
 typedef unsigned int state;
 typedef char input_symbol;
@@ -27,6 +34,34 @@ class ENFA {
   // Epsilon is taken as constant
   static const input_symbol EPSILON;
 
+  /**
+   Engines used by ENFA::evaluate() for simulating the automaton.
+   */
+  enum Engine {
+    // Set of states, tf() is called for every input symbol
+    ENGINE_SET,
+    // Each reached set of states is cached as a DFA state along with its
+    // transitions, i.e. the DFA is constructed lazily while evaluating
+    ENGINE_LAZY_DFA,
+    // Set of states as a bitset, a step ORs precomputed successor masks (with
+    // e-closures applied) of the current states. Automata having more than
+    // MAX_BITSET_STATES states use a sparse set of states instead. The choice
+    // is made once by the total states, not per step by the size of the
+    // current set: the masks take n_states bits per state and symbol, which
+    // is what a large automaton can't afford even when few states are
+    // active. Nothing is allocated while evaluating.
+    ENGINE_BIT_PARALLEL
+  };
+
+  // Statistics of the lazy DFA cache
+  typedef ::CacheStats CacheStats;
+
+  // Default memory budget of the lazy DFA cache in bytes
+  static const size_t DEFAULT_CACHE_BUDGET = 8 << 20;
+
+  // States above which ENGINE_BIT_PARALLEL uses a sparse set of states
+  static const int MAX_BITSET_STATES = 1024;
+
   /**
    Constructor.
    @param n_states Total states
@@ -46,21 +81,78 @@ class ENFA {
   bool evaluate(const string &str);
 
   /**
-   Find e-closures starting with some state
+   Search the given string for substrings accepted by the automaton, i.e. a
+   match may start and end anywhere. Threads in states which can no longer
+   reach an accepting state are dropped, and scanning stops as soon as the
+   answer is known, see SearchMode. e-closures have to be found first.
+   @param str String to search
+   @param mode What to report
+   @param matches Output: matches in increasing end offset
+   @return True if there is a match, false otherwise
+   */
+  bool search(const string &str, SearchMode mode, vector<Match> *matches);
 
-   NOTE: This is a recursive function
-   @param i_state Input state (default: 0)
+  /**
+   Select the engine used by evaluate().
+   @param engine Engine to use (default: ENGINE_SET)
    */
-  void findEClosures(state i_state = 0);
+  void set_engine(Engine engine) { this->engine = engine; }
 
   /**
-   Find epsilon state for some state and save them to t_state
+   Set memory budget of the lazy DFA cache, the cache is flushed whenever
+   adding a DFA state would exceed the budget.
+   @param bytes Memory budget in bytes
+   */
+  void set_cache_budget(size_t bytes) { cache_budget = bytes; }
 
-   NOTE: This is a recursive function
+  /**
+   Get statistics of the lazy DFA cache.
+   @return Cache statistics
+   */
+  const CacheStats &get_cache_stats() const { return cache_stats; }
+
+  /**
+   Find e-closures of all states at once.
+
+   Strongly connected components of the epsilon transitions are found using
+   Tarjan's algorithm, all states of a component share the same e-closure.
+   Components are completed in reverse topological order, so the e-closure of
+   a component is its states plus the already known e-closures of the
+   components it has epsilon transitions to. Epsilon cycles are fine and
+   e-closures are sorted without duplicates.
+   */
+  void findEClosures();
+
+  /**
+   Find states reachable from some state using one or more epsilon
+   transitions and save them to t_state
    @param i_state Input state
    */
   void findEStates(state i_state);
 
+  /**
+   Remove epsilon transitions.
+
+   e-closures are folded into the other transitions once, i.e. a state goes
+   on an input symbol to wherever any state of its e-closure went, and a state
+   is accepting if its e-closure has an accepting state. States unreachable
+   from the start state are removed and the rest are numbered in breadth-first
+   order, the start state being q0. EPSILON is not part of the alphabet of the
+   new automaton, so none of the engines has to look at e-closures anymore.
+   e-closures of this automaton are found first.
+   @return Equivalent automaton without any epsilon transition
+   */
+  ENFA remove_epsilon();
+
+  /**
+   Get e-closure of a state, findEClosures() has to be called first.
+   @param q State
+   @return Sorted e-closure of the state
+   */
+  const vector<state> &eclose(state q) const {
+    return e_closures[e_closure_index[q]];
+  }
+
   /**
    Print all e-closures
    */
@@ -74,6 +166,54 @@ class ENFA {
    */
   void set_state(state q, input_symbol e, state s);
 
+  /**
+   Insert many destination states at once, allocating only once.
+   @param q Current state
+   @param e Input symbol to set
+   @param first First destination state
+   @param last End of the destination states
+   */
+  void set_states(state q, input_symbol e, const state *first,
+                  const state *last);
+
+  /**
+   Get total states.
+   @return Total states
+   */
+  int get_n_states() const { return n_states; }
+
+  /**
+   Get input symbols.
+   @return Input symbols
+   */
+  const vector<input_symbol> &get_input_symbols() const {
+    return input_symbols;
+  }
+
+  /**
+   Get start state.
+   @return Start state
+   */
+  state get_start_state() const { return start_state; }
+
+  /**
+   Get accepting states.
+   @return Accepting states
+   */
+  const vector<state> &get_accepting_states() const {
+    return accepting_states;
+  }
+
+  /**
+   Get destination states by the index of an input symbol.
+   @param q Current state
+   @param index Index of input_symbols array
+   @return Destination states
+   */
+  const vector<state> &get_transitions(state q, int index) const {
+    return transition_table[q][index];
+  }
+
   /**
    Transition function.
    @param q Current state
@@ -86,15 +226,93 @@ class ENFA {
   // Accepting states
   const vector<state> accepting_states;
 
+  // Lazy DFA: transitions, row-major with one column per input symbol, -1 if
+  // not computed yet
+  vector<int> cache_transitions;
+
+  // Lazy DFA: set of states of each cached DFA state
+  vector< vector<state> > cache_states;
+
+  // Lazy DFA: whether each cached DFA state is accepting
+  vector<bool> cache_accepting;
+
+  // Lazy DFA: cached DFA state of a set of states
+  std::unordered_map<vector<state>, int, StatesHash> cache_index;
+
+  // Lazy DFA: cached DFA state of the e-closure of the start state, -1 if not
+  // cached
+  int cache_start;
+
+  // Lazy DFA: cached DFA state of the empty set, looping on every input
+  // symbol, -1 if not cached
+  int cache_dead;
+
+  // Lazy DFA: memory budget in bytes
+  size_t cache_budget;
+
+  // Lazy DFA: statistics
+  CacheStats cache_stats;
+
+  // Engine used by evaluate()
+  Engine engine;
+
+  // Bit parallel: whether the tables below are up to date
+  bool bit_ready;
+
+  // Bit parallel: words per bitset
+  int bit_words;
+
+  // Bit parallel: successor mask of each state and input symbol, i.e.
+  // bit_successors[(q * n_input_symbols + e) * bit_words]
+  vector<uint64_t> bit_successors;
+
+  // Bit parallel: accepting states mask
+  vector<uint64_t> bit_accepting;
+
+  // Bit parallel: start state mask, i.e. e-closure of the start state
+  vector<uint64_t> bit_start;
+
+  // Bit parallel: current and next set of states
+  vector<uint64_t> bit_current, bit_next;
+
+  // Sparse set: successors of each state and input symbol, i.e.
+  // sparse_targets[sparse_offsets[q * n_input_symbols + e]..]
+  vector<int> sparse_offsets;
+  vector<state> sparse_targets;
+
+  // Sparse set: whether each state is accepting
+  vector<bool> sparse_accepting;
+
+  // Sparse set: current and next set of states (dense part)
+  vector<state> sparse_current, sparse_next;
+
+  // Sparse set: position of each state in sparse_next
+  vector<int> sparse_index;
+
+  // Search: whether search_accepting and search_live are up to date
+  bool search_ready;
+
+  // Search: whether each state is accepting
+  vector<bool> search_accepting;
+
+  // Search: whether each state can reach an accepting state
+  vector<bool> search_live;
+
+  // Index of each input symbol (as unsigned char), -1 if not an input symbol
+  int symbol_index[256];
+
   // Current state
   vector<state> current_state;
 
   // Input symbols
   const vector<input_symbol> input_symbols;
 
-  // Calculated e-closures
+  // Calculated e-closures, one per strongly connected component
   vector< vector<state> > e_closures;
 
+  // Index of e_closures of each state
+  vector<int> e_closure_index;
+
   // Location of epsilon in the input symbols table
   int epsilon_loc;
 
@@ -113,6 +331,49 @@ class ENFA {
   // Transition table
   vector< vector< vector<state> > > transition_table;
 
+  /**
+   Evaluate the given string using the lazy DFA.
+   @param str String evaluate
+   @return True on accepted, false on rejected
+   */
+  bool evaluate_lazy(const string &str);
+
+  /**
+   Evaluate the given string using the bit parallel engine.
+   @param str String evaluate
+   @return True on accepted, false on rejected
+   */
+  bool evaluate_bit_parallel(const string &str);
+
+  /**
+   Evaluate the given string using sparse sets of states.
+   @param str String evaluate
+   @return True on accepted, false on rejected
+   */
+  bool evaluate_sparse(const string &str);
+
+  /**
+   Build the tables of the bit parallel engine.
+   */
+  void build_bit_parallel();
+
+  /**
+   Find the accepting states and the states which can reach one for search().
+   */
+  void find_live_states();
+
+  /**
+   Get the cached DFA state of a set of states, adding it if not cached.
+   @param states Sorted set of states
+   @return Cached DFA state
+   */
+  int cache_state(const vector<state> &states);
+
+  /**
+   Flush the lazy DFA cache.
+   */
+  void clear_cache();
+
   /**
    Get index by input symbol.
    @param e Input symbol
@@ -58,7 +58,8 @@ int main() {
   // Find e-closures
   aENFA.findEClosures();
   aENFA.printEClosures();
-  // Match string
+  // Match string, reached sets of states are cached as DFA states
+  aENFA.set_engine(ENFA::ENGINE_LAZY_DFA);
   string str;
   while (true) {
     cout << "Enter a string: "; cin >> str;
@@ -68,5 +69,9 @@ int main() {
          << (status ? "Accepted" : "Rejected")
          << "\n" << endl;
   }
+  const ENFA::CacheStats &stats = aENFA.get_cache_stats();
+  cout << "Cache: " << stats.states << " DFA states, "
+       << stats.hits << " hits, " << stats.misses << " misses (hit rate "
+       << 100 * stats.hit_rate() << "%)" << endl;
   return 0;
 }